@@ -0,0 +1,253 @@
+#include "allpairs.h"
+#include "dense.h"
+#include "frozengraph.h"
+#include "threadpool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+// Builds the table, picking Floyd-Warshall or per-source Dijkstra by estimated work unless a method is forced
+AllPairsTable::BuildStats AllPairsTable::build(const FrozenGraph& g, ThreadPool& pool, Metric m, Method method) {
+    auto start = std::chrono::steady_clock::now();
+    n = g.vertexCount();
+    metric = m;
+    size_t cells = static_cast<size_t>(n) * n;
+    keys.assign(cells, UNREACHABLE);
+    secondary.assign(cells, 0);
+    nextHop16.clear();
+    nextHop32.clear();
+
+    if (method == Method::Auto) {
+        // Blocked Floyd-Warshall does n^3 branch-free steps; a heap Dijkstra per source costs roughly
+        // (E + V) log V scattered steps. The weights are calibrated against benchmarkAllPairs. Graphs dense enough
+        // for the dense engine always take Dijkstra: its n^2 SIMD cells per source run 3-4x faster than n^3
+        // Floyd-Warshall steps
+        double floyd = std::pow(static_cast<double>(n), 3);
+        double dijkstra = static_cast<double>(n) * (g.edgeCount() + n) * std::log2(n + 2.0) * 1.3;
+        bool dense = g.denseMatrix(metric) != nullptr;
+        method = (floyd < dijkstra && !dense) ? Method::FloydWarshall : Method::Dijkstra;
+    }
+    if (method == Method::FloydWarshall) {
+        buildFloydWarshall(g, pool);
+    } else {
+        buildDijkstra(g, pool);
+    }
+
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return {method, elapsed.count(), memoryBytes()};
+}
+
+// Returns the bytes held by the matrices
+size_t AllPairsTable::memoryBytes() const {
+    return keys.size() * sizeof(int32_t) + secondary.size() * sizeof(int32_t) +
+           nextHop16.size() * sizeof(uint16_t) + nextHop32.size() * sizeof(int32_t);
+}
+
+// One Dijkstra per source, run in parallel; next hops are read off each source's shortest-path tree. Small dense
+// graphs run the dense engine per source instead of the heap
+void AllPairsTable::buildDijkstra(const FrozenGraph& g, ThreadPool& pool) {
+    bool narrow = n < 0xFFFF;
+    if (narrow) nextHop16.assign(static_cast<size_t>(n) * n, 0xFFFF);
+    else nextHop32.assign(static_cast<size_t>(n) * n, -1);
+    const DenseMatrix* matrix = g.denseMatrix(metric);
+
+    pool.parallelFor(n, [&](size_t source) {
+        if (matrix) {
+            DenseWorkspace& ws = DenseWorkspace::local();
+            denseDijkstra(*matrix, static_cast<int>(source), -1, ws);
+            fillRow(static_cast<int>(source), ws, [&](int v) { return ws.settled(v); }, [&](int v) { return ws.secondary(v); });
+        } else {
+            SearchWorkspace& ws = SearchWorkspace::local();
+            dijkstra(g, static_cast<int>(source), -1, ws, metric);
+            fillRow(static_cast<int>(source), ws, [&](int v) { return ws.reached(v); },
+                    [&](int v) { return (metric == Metric::Distance) ? ws.cost(v) : ws.distance(v); });
+        }
+    });
+}
+
+// Writes the row of source from a finished search: keys, secondary totals, and next hops read off its
+// shortest-path tree. Labels is either workspace; reached and secondaryOf read it
+template <typename Labels, typename Reached, typename Secondary>
+void AllPairsTable::fillRow(int source, const Labels& ws, Reached&& reached, Secondary&& secondaryOf) {
+    bool narrow = n < 0xFFFF;
+    size_t row = static_cast<size_t>(source) * n;
+    thread_local std::vector<int> hop, stack;
+    hop.assign(n, -1);
+    for (int v = 0; v < n; ++v) {
+        if (!reached(v)) continue;
+        keys[row + v] = ws.key(v);
+        secondary[row + v] = secondaryOf(v);
+
+        // First hop: climb the tree until a vertex whose hop is known or whose parent is the source
+        int at = v;
+        while (hop[at] == -1 && at != source && ws.parent(at) != source) {
+            stack.push_back(at);
+            at = ws.parent(at);
+        }
+        int first = (at == source) ? at : (hop[at] != -1 ? hop[at] : at);
+        hop[at] = first;
+        for (int x : stack) hop[x] = first;
+        stack.clear();
+    }
+    for (int v = 0; v < n; ++v) {
+        if (hop[v] == -1) continue;
+        if (narrow) nextHop16[row + v] = static_cast<uint16_t>(hop[v]);
+        else nextHop32[row + v] = hop[v];
+    }
+}
+
+// Seeds the matrices with direct flights and runs the blocked kernel
+void AllPairsTable::buildFloydWarshall(const FrozenGraph& g, ThreadPool& pool) {
+    for (int u = 0; u < n; ++u) {
+        size_t row = static_cast<size_t>(u) * n;
+        keys[row + u] = 0;
+        for (int e = g.edgeBegin(u); e < g.edgeEnd(u); ++e) {
+            int v = g.edgeTarget(e);
+            int key = (metric == Metric::Distance) ? g.edgeDistance(e) : g.edgeCost(e);
+            int other = (metric == Metric::Distance) ? g.edgeCost(e) : g.edgeDistance(e);
+            if (v != u && key < keys[row + v]) {
+                keys[row + v] = key;
+                secondary[row + v] = other;
+            }
+        }
+    }
+    if (n < 0xFFFF) {
+        nextHop16.assign(static_cast<size_t>(n) * n, 0xFFFF);
+        for (size_t c = 0; c < keys.size(); ++c) if (keys[c] < UNREACHABLE) nextHop16[c] = static_cast<uint16_t>(c % n);
+        floydWarshall(nextHop16, pool);
+    } else {
+        nextHop32.assign(static_cast<size_t>(n) * n, -1);
+        for (size_t c = 0; c < keys.size(); ++c) if (keys[c] < UNREACHABLE) nextHop32[c] = static_cast<int32_t>(c % n);
+        floydWarshall(nextHop32, pool);
+    }
+    retotalSecondary(g, pool);
+}
+
+// Floyd-Warshall keeps next hops and keys consistent, but when two routes tie on the key the secondary total can
+// belong to the other one. Recompute it along the stored next hops: secondary(i, j) = leg(i, hop) + secondary(hop, j)
+void AllPairsTable::retotalSecondary(const FrozenGraph& g, ThreadPool& pool) {
+    // Secondary value of the flight each hop takes (the first flight with the smallest key, as in the seed)
+    auto legSecondary = [&](int from, int to) {
+        int bestKey = UNREACHABLE, best = 0;
+        for (int e = g.edgeBegin(from); e < g.edgeEnd(from); ++e) {
+            if (g.edgeTarget(e) != to) continue;
+            int key = (metric == Metric::Distance) ? g.edgeDistance(e) : g.edgeCost(e);
+            if (key < bestKey) {
+                bestKey = key;
+                best = (metric == Metric::Distance) ? g.edgeCost(e) : g.edgeDistance(e);
+            }
+        }
+        return best;
+    };
+
+    pool.parallelFor(n, [&](size_t column) {
+        int j = static_cast<int>(column);
+        thread_local std::vector<char> done;
+        thread_local std::vector<int> chain;
+        done.assign(n, 0);
+        done[j] = 1;
+        secondary[static_cast<size_t>(j) * n + j] = 0;
+        for (int i = 0; i < n; ++i) {
+            if (!reachable(i, j)) continue;
+            // Walk the hop chain to the first vertex with a known total, then unwind
+            int at = i;
+            while (!done[at] && static_cast<int>(chain.size()) <= n) {
+                chain.push_back(at);
+                at = nextHop(at, j);
+            }
+            for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+                int hop = nextHop(*it, j);
+                secondary[static_cast<size_t>(*it) * n + j] = legSecondary(*it, hop) + secondary[static_cast<size_t>(hop) * n + j];
+                done[*it] = 1;
+            }
+            chain.clear();
+        }
+    });
+}
+
+// Cache-blocked Floyd-Warshall: for each diagonal block, update it, then its block row and column, then every
+// other block, in parallel. The innermost loop is a branch-free select over contiguous rows, which compilers
+// vectorize (SSE/AVX) at -O2 and above
+template <typename Next>
+void AllPairsTable::floydWarshall(std::vector<Next>& next, ThreadPool& pool) {
+    int blocks = (n + BLOCK - 1) / BLOCK;
+    int32_t* key = keys.data();
+    int32_t* other = secondary.data();
+    Next* hop = next.data();
+
+    // Relaxes block (bi, bj) through the k range of block bk
+    auto relaxBlock = [&](int bi, int bj, int bk) {
+        int iEnd = std::min(n, (bi + 1) * BLOCK), jBegin = bj * BLOCK, jEnd = std::min(n, (bj + 1) * BLOCK);
+        int kEnd = std::min(n, (bk + 1) * BLOCK);
+        for (int k = bk * BLOCK; k < kEnd; ++k) {
+            const int32_t* keyK = key + static_cast<size_t>(k) * n;
+            const int32_t* otherK = other + static_cast<size_t>(k) * n;
+            for (int i = bi * BLOCK; i < iEnd; ++i) {
+                size_t row = static_cast<size_t>(i) * n;
+                int32_t viaKey = key[row + k];
+                if (viaKey >= UNREACHABLE) continue;
+                int32_t viaOther = other[row + k];
+                Next viaHop = hop[row + k];
+                int32_t* keyI = key + row;
+                int32_t* otherI = other + row;
+                Next* hopI = hop + row;
+                for (int j = jBegin; j < jEnd; ++j) {
+                    int32_t candidate = viaKey + keyK[j];
+                    bool better = candidate < keyI[j];
+                    keyI[j] = better ? candidate : keyI[j];
+                    otherI[j] = better ? viaOther + otherK[j] : otherI[j];
+                    hopI[j] = better ? viaHop : hopI[j];
+                }
+            }
+        }
+    };
+
+    for (int bk = 0; bk < blocks; ++bk) {
+        relaxBlock(bk, bk, bk);
+        pool.parallelFor(2 * blocks, [&](size_t t) {
+            int b = static_cast<int>(t / 2);
+            if (b == bk) return;
+            if (t % 2 == 0) relaxBlock(bk, b, bk); // Block row
+            else relaxBlock(b, bk, bk);            // Block column
+        });
+        pool.parallelFor(static_cast<size_t>(blocks) * blocks, [&](size_t t) {
+            int bi = static_cast<int>(t / blocks), bj = static_cast<int>(t % blocks);
+            if (bi != bk && bj != bk) relaxBlock(bi, bj, bk);
+        });
+    }
+}
+
+// Returns the vertex after origin on the stored route to destination
+int AllPairsTable::nextHop(int origin, int destination) const {
+    size_t cell = static_cast<size_t>(origin) * n + destination;
+    return nextHop16.empty() ? nextHop32[cell] : nextHop16[cell];
+}
+
+// Returns the route distance from origin to destination (-1 if unreachable)
+int AllPairsTable::distance(int origin, int destination) const {
+    if (!reachable(origin, destination)) return -1;
+    size_t cell = static_cast<size_t>(origin) * n + destination;
+    return (metric == Metric::Distance) ? keys[cell] : secondary[cell];
+}
+
+// Returns the route cost from origin to destination (-1 if unreachable)
+int AllPairsTable::cost(int origin, int destination) const {
+    if (!reachable(origin, destination)) return -1;
+    size_t cell = static_cast<size_t>(origin) * n + destination;
+    return (metric == Metric::Cost) ? keys[cell] : secondary[cell];
+}
+
+// Returns the stored route, unpacked hop by hop
+RouteResult AllPairsTable::route(int origin, int destination) const {
+    RouteResult result;
+    if (!reachable(origin, destination)) return result;
+    result.found = true;
+    result.distance = distance(origin, destination);
+    result.cost = cost(origin, destination);
+    result.path.push_back(origin);
+    for (int at = origin; at != destination && static_cast<int>(result.path.size()) <= n;) {
+        at = nextHop(at, destination);
+        result.path.push_back(at);
+    }
+    return result;
+}
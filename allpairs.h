@@ -0,0 +1,60 @@
+#ifndef ALLPAIRS_H
+#define ALLPAIRS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "routing.h"
+
+class FrozenGraph;
+class ThreadPool;
+
+// Precomputed all-pairs route table with O(1) distance/cost lookups and next-hop path unpacking.
+// Rows are stored densely: 32-bit keys and secondary totals, and 16-bit next hops when the graph has
+// fewer than 65535 airports (32-bit otherwise).
+class AllPairsTable {
+public:
+    enum class Method { Auto, FloydWarshall, Dijkstra };
+
+    // Largest graph Graph::useAllPairs builds tables for: about 10 bytes per pair and metric, 320 MiB for both
+    static constexpr int SNAPSHOT_MAX_VERTICES = 4096;
+
+    struct BuildStats {
+        Method method;
+        double milliseconds;
+        size_t bytes;
+    };
+
+private:
+    static constexpr int32_t UNREACHABLE = 1 << 30; // Keeps a + b from overflowing inside Floyd-Warshall
+    static constexpr int BLOCK = 64;
+
+    int n = 0;
+    Metric metric = Metric::Distance;
+    std::vector<int32_t> keys;      // Minimized metric, n * n
+    std::vector<int32_t> secondary; // The other metric along the same route
+    std::vector<uint16_t> nextHop16;
+    std::vector<int32_t> nextHop32;
+
+    int nextHop(int origin, int destination) const;
+    void buildDijkstra(const FrozenGraph& g, ThreadPool& pool);
+    template <typename Labels, typename Reached, typename Secondary>
+    void fillRow(int source, const Labels& ws, Reached&& reached, Secondary&& secondaryOf);
+    void buildFloydWarshall(const FrozenGraph& g, ThreadPool& pool);
+    template <typename Next>
+    void floydWarshall(std::vector<Next>& next, ThreadPool& pool);
+    void retotalSecondary(const FrozenGraph& g, ThreadPool& pool);
+
+public: // See implementation file for details
+    BuildStats build(const FrozenGraph& g, ThreadPool& pool, Metric metric = Metric::Distance, Method method = Method::Auto);
+
+    int vertexCount() const { return n; }
+    Metric getMetric() const { return metric; }
+    size_t memoryBytes() const;
+    bool reachable(int origin, int destination) const { return keys[static_cast<size_t>(origin) * n + destination] < UNREACHABLE; }
+    int distance(int origin, int destination) const;
+    int cost(int origin, int destination) const;
+    RouteResult route(int origin, int destination) const;
+};
+
+#endif
@@ -0,0 +1,102 @@
+#include "batch.h"
+#include "frozengraph.h"
+#include "threadpool.h"
+#include <algorithm>
+#include <numeric>
+
+namespace {
+
+// Returns query indices sorted by origin, plus the [begin, end) boundaries of each origin's group
+template <typename Query>
+void groupByOrigin(const std::vector<Query>& queries, std::vector<size_t>& order, std::vector<size_t>& groupStarts) {
+    order.resize(queries.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return queries[a].origin < queries[b].origin; });
+    groupStarts.clear();
+    for (size_t i = 0; i < order.size(); ++i) {
+        if (i == 0 || queries[order[i]].origin != queries[order[i - 1]].origin) groupStarts.push_back(i);
+    }
+    groupStarts.push_back(order.size());
+}
+
+// Returns true if the index is a valid vertex of g
+bool validVertex(const FrozenGraph& g, int v) {
+    return v >= 0 && v < g.vertexCount();
+}
+
+} // namespace
+
+// Answers point-to-point queries; each origin group runs one search that stops once all its destinations are settled
+std::vector<RouteResult> batchShortestRoutes(const FrozenGraph& g, const std::vector<RouteQuery>& queries, ThreadPool& pool, Metric metric) {
+    std::vector<RouteResult> results(queries.size());
+    std::vector<size_t> order, groupStarts;
+    groupByOrigin(queries, order, groupStarts);
+
+    pool.parallelFor(groupStarts.size() - 1, [&](size_t group) {
+        int origin = queries[order[groupStarts[group]]].origin;
+        if (!validVertex(g, origin)) return;
+        // Destinations the connectivity index rules out are dropped; one of them would make the search
+        // below run over the origin's whole reachable set before giving up
+        std::vector<int> targets;
+        for (size_t i = groupStarts[group]; i < groupStarts[group + 1]; ++i) {
+            int destination = queries[order[i]].destination;
+            if (validVertex(g, destination) && g.mayReach(origin, destination)) targets.push_back(destination);
+        }
+        if (targets.empty()) return;
+
+        // A lone destination is answered by a bidirectional search, which settles far fewer airports
+        if (groupStarts[group + 1] - groupStarts[group] == 1) {
+            bidirectionalDijkstra(g, origin, targets[0], SearchWorkspace::local(0), SearchWorkspace::local(1),
+                                  results[order[groupStarts[group]]], metric);
+            return;
+        }
+
+        SearchWorkspace& ws = SearchWorkspace::local();
+        dijkstraToTargets(g, origin, targets, ws, metric);
+        for (size_t i = groupStarts[group]; i < groupStarts[group + 1]; ++i) {
+            int destination = queries[order[i]].destination;
+            if (validVertex(g, destination) && ws.settled(destination)) extractRoute(ws, destination, results[order[i]]);
+        }
+    });
+    return results;
+}
+
+// Answers origin/state queries; each origin group runs one search that stops once every airport in its states is settled
+std::vector<std::vector<RouteResult>> batchRoutesToState(const FrozenGraph& g, const std::vector<StateQuery>& queries,
+                                                         ThreadPool& pool, Metric metric) {
+    std::vector<std::vector<RouteResult>> results(queries.size());
+    std::vector<size_t> order, groupStarts;
+    groupByOrigin(queries, order, groupStarts);
+
+    pool.parallelFor(groupStarts.size() - 1, [&](size_t group) {
+        int origin = queries[order[groupStarts[group]]].origin;
+        if (!validVertex(g, origin)) return;
+
+        // Reachable airports in any of the group's states, looked up through the state index
+        std::vector<int> stateIds;
+        for (size_t i = groupStarts[group]; i < groupStarts[group + 1]; ++i) stateIds.push_back(g.getStateId(queries[order[i]].state));
+        std::sort(stateIds.begin(), stateIds.end());
+        stateIds.erase(std::unique(stateIds.begin(), stateIds.end()), stateIds.end());
+        std::vector<int> targets;
+        for (int id : stateIds) {
+            for (int j = (id == -1) ? 0 : g.stateBegin(id); id != -1 && j < g.stateEnd(id); ++j) {
+                if (g.mayReach(origin, g.stateAirport(j))) targets.push_back(g.stateAirport(j));
+            }
+        }
+        if (targets.empty()) return;
+
+        SearchWorkspace& ws = SearchWorkspace::local();
+        dijkstraToTargets(g, origin, targets, ws, metric);
+        for (size_t i = groupStarts[group]; i < groupStarts[group + 1]; ++i) {
+            std::vector<RouteResult>& routes = results[order[i]];
+            int id = g.getStateId(queries[order[i]].state);
+            for (int j = (id == -1) ? 0 : g.stateBegin(id); id != -1 && j < g.stateEnd(id); ++j) {
+                int v = g.stateAirport(j);
+                if (!ws.settled(v)) continue;
+                routes.emplace_back();
+                extractRoute(ws, v, routes.back());
+            }
+        }
+    });
+    return results;
+}
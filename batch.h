@@ -0,0 +1,31 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <string>
+#include <vector>
+#include "routing.h"
+
+class FrozenGraph;
+class ThreadPool;
+
+// Origin/destination query by airport index
+struct RouteQuery {
+    int origin;
+    int destination;
+};
+
+// Origin/state query: routes from origin to every reachable airport in state
+struct StateQuery {
+    int origin;
+    std::string state;
+};
+
+// Batched query engines. Queries are grouped by origin so a single search answers every query sharing it
+// (an origin with a single destination gets a bidirectional search instead), groups run in parallel on the
+// pool against the read-only graph, and results come back in input order.
+std::vector<RouteResult> batchShortestRoutes(const FrozenGraph& g, const std::vector<RouteQuery>& queries, ThreadPool& pool,
+                                             Metric metric = Metric::Distance);
+std::vector<std::vector<RouteResult>> batchRoutesToState(const FrozenGraph& g, const std::vector<StateQuery>& queries,
+                                                         ThreadPool& pool, Metric metric = Metric::Distance);
+
+#endif
@@ -0,0 +1,1249 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstdio>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <shared_mutex>
+#include <sstream>
+#include <fstream>
+#include <functional>
+#include <malloc.h>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "graph.h"
+#include "pareto.h"
+#include "contraction.h"
+#include "snapshot.h"
+#include "loader.h"
+#include "batch.h"
+#include "threadpool.h"
+#include "allpairs.h"
+#include "spanning.h"
+#include "landmarks.h"
+#include "querycache.h"
+#include "metrics.h"
+#include "queryserver.h"
+#include "kshortest.h"
+#include "dense.h"
+#include "deltastepping.h"
+
+// Benchmarks for the graph query engines.
+// Run without arguments for the engine comparisons, or with --suite [maxAirports] for the regression suite, which
+// prints one JSON object per line with latency percentiles and throughput of every public Graph operation.
+// Build: g++ -std=c++17 -O2 -o benchmark benchmark.cpp graph.cpp frozengraph.cpp routing.cpp pareto.cpp contraction.cpp snapshot.cpp mappedfile.cpp loader.cpp threadpool.cpp batch.cpp allpairs.cpp connectivity.cpp spanning.cpp degrees.cpp landmarks.cpp querycache.cpp metrics.cpp metadata.cpp queryserver.cpp kshortest.cpp dense.cpp deltastepping.cpp -pthread
+
+// Returns a synthetic airport code: the index written in base 26, so codes stay unique at any size
+std::string syntheticCode(int index) {
+    std::string s;
+    do {
+        s.insert(s.begin(), char('A' + index % 26));
+        index /= 26;
+    } while (index > 0);
+    while (s.size() < 3) s.insert(s.begin(), 'A');
+    return s;
+}
+
+// Generates a deterministic hub-and-spoke network: every airport flies to a few hubs and hubs fly to each other
+Graph makeSyntheticGraph(int airportCount, int flightsPerAirport, unsigned seed) {
+    std::mt19937 rng(seed);
+    int hubCount = std::max(1, airportCount / 50);
+    std::uniform_int_distribution<int> hubPick(0, hubCount - 1);
+    std::uniform_int_distribution<int> anyPick(0, airportCount - 1);
+    std::uniform_int_distribution<int> distancePick(100, 3000);
+
+    std::vector<Graph::FlightRecord> rows;
+    rows.reserve(static_cast<size_t>(airportCount) * flightsPerAirport);
+    for (int i = 0; i < airportCount; ++i) {
+        for (int j = 0; j < flightsPerAirport; ++j) {
+            int dest = (i < hubCount || j == flightsPerAirport - 1) ? anyPick(rng) : hubPick(rng);
+            if (dest == i) continue;
+            int distance = distancePick(rng);
+            int cost = distance / 4 + distancePick(rng) / 10; // Cost loosely follows distance
+            rows.push_back({syntheticCode(i), "S" + std::to_string(i % 50), syntheticCode(dest), "S" + std::to_string(dest % 50), distance, cost, "", ""});
+        }
+    }
+
+    Graph g;
+    g.addFlights(rows);
+    return g;
+}
+
+// Dijkstra over the per-vertex adjacency lists, exactly as the query engines ran before the CSR snapshot
+int legacyShortestDistance(const Graph& g, int src, int dest) {
+    int n = g.airportCount();
+    std::vector<int> distances(n, std::numeric_limits<int>::max());
+    std::vector<bool> visited(n, false);
+    distances[src] = 0;
+    int cur = src;
+    int visited_count = 0;
+    while (visited_count < n) {
+        for (const auto& edge : g.getFlights(cur)) {
+            int neighbor = edge.destIndex;
+            if (!visited[neighbor] && distances[cur] + edge.distance < distances[neighbor]) {
+                distances[neighbor] = distances[cur] + edge.distance;
+            }
+        }
+        int minDist = std::numeric_limits<int>::max();
+        cur = -1;
+        for (int j = 0; j < n; j++) {
+            if (!visited[j] && distances[j] < minDist) {
+                minDist = distances[j];
+                cur = j;
+            }
+        }
+        if (cur == -1) break;
+        visited[cur] = true;
+        visited_count++;
+    }
+    return distances[dest];
+}
+
+// Times a callable over the given number of repetitions and returns milliseconds per repetition
+template <typename F>
+double timeMs(int repetitions, F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repetitions; ++r) f();
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / repetitions;
+}
+
+// Compares the per-airport adjacency vectors against the frozen CSR layout
+void benchmarkLayouts(int airportCount) {
+    Graph g = makeSyntheticGraph(airportCount, 8, 42);
+    FrozenGraph frozen;
+    double freezeMs = timeMs(1, [&] { frozen = g.freeze(); });
+    long long sink = 0;
+
+    // Full edge sweep, the inner loop of every relaxation
+    double sweepLegacy = timeMs(20, [&] {
+        for (int v = 0; v < g.airportCount(); ++v)
+            for (const auto& edge : g.getFlights(v)) sink += edge.distance + edge.destIndex;
+    });
+    double sweepFrozen = timeMs(20, [&] {
+        for (int v = 0; v < frozen.vertexCount(); ++v)
+            for (int e = frozen.edgeBegin(v); e < frozen.edgeEnd(v); ++e) sink += frozen.edgeDistance(e) + frozen.edgeTarget(e);
+    });
+
+    // Point-to-point query with output suppressed
+    int queries = 5;
+    double queryLegacy = timeMs(queries, [&] { sink += legacyShortestDistance(g, 0, airportCount - 1); });
+    std::ostringstream discard;
+    std::streambuf* saved = std::cout.rdbuf(discard.rdbuf());
+    double queryFrozen = timeMs(queries, [&] {
+        frozen.shortestPath(frozen.getAirportCode(0), frozen.getAirportCode(airportCount - 1));
+    });
+    std::cout.rdbuf(saved);
+
+    std::cout << "layout V=" << frozen.vertexCount() << " E=" << frozen.edgeCount()
+              << " | freeze " << freezeMs << " ms"
+              << " | edge sweep legacy " << sweepLegacy << " ms, csr " << sweepFrozen << " ms (x" << sweepLegacy / sweepFrozen << ")"
+              << " | shortestPath legacy " << queryLegacy << " ms, current " << queryFrozen << " ms (x" << queryLegacy / queryFrozen << ")"
+              << (sink == 42 ? " " : "") << std::endl;
+}
+
+// Measures the data-returning heap engine over many queries and checks it against the legacy O(V^2) search
+void benchmarkDijkstra(int airportCount) {
+    Graph g = makeSyntheticGraph(airportCount, 8, 7);
+    FrozenGraph frozen = g.freeze();
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<int> pick(0, frozen.vertexCount() - 1);
+
+    // Correctness spot check
+    for (int i = 0; i < 3; ++i) {
+        int src = pick(rng), dst = pick(rng);
+        RouteResult route = frozen.shortestRoute(src, dst);
+        int expected = legacyShortestDistance(g, src, dst);
+        if (route.found != (expected != std::numeric_limits<int>::max()) || (route.found && route.distance != expected)) {
+            std::cout << "dijkstra MISMATCH " << src << " -> " << dst << std::endl;
+        }
+    }
+
+    int queries = 2000;
+    long long sink = 0;
+    RouteResult route;
+    double perQuery = timeMs(queries, [&] {
+        SearchWorkspace& ws = SearchWorkspace::local();
+        int dst = pick(rng);
+        dijkstra(frozen, pick(rng), dst, ws);
+        extractRoute(ws, dst, route);
+        sink += route.distance;
+    });
+    double legacy = timeMs(3, [&] { sink += legacyShortestDistance(g, pick(rng), pick(rng)); });
+    std::cout << "dijkstra V=" << frozen.vertexCount() << " | heap " << perQuery * 1000 << " us/query, "
+              << 1000.0 / perQuery << " queries/s | legacy " << legacy * 1000 << " us/query (x" << legacy / perQuery << ")"
+              << (sink == 42 ? " " : "") << std::endl;
+}
+
+// Compares Pareto frontier queries against single-criterion Dijkstra on the same pairs
+void benchmarkPareto(int airportCount) {
+    FrozenGraph frozen = makeSyntheticGraph(airportCount, 8, 11).freeze();
+    std::mt19937 rng(3);
+    std::uniform_int_distribution<int> pick(0, frozen.vertexCount() - 1);
+    std::vector<std::pair<int, int>> pairs(200);
+    for (auto& pair : pairs) pair = {pick(rng), pick(rng)};
+
+    long long sink = 0;
+    size_t frontierSize = 0;
+    size_t i = 0;
+    double single = timeMs(static_cast<int>(pairs.size()), [&] {
+        sink += frozen.shortestRoute(pairs[i].first, pairs[i].second).distance;
+        i = (i + 1) % pairs.size();
+    });
+    double pareto = timeMs(static_cast<int>(pairs.size()), [&] {
+        frontierSize += frozen.paretoRoutes(pairs[i].first, pairs[i].second).size();
+        i = (i + 1) % pairs.size();
+    });
+    std::cout << "pareto V=" << frozen.vertexCount() << " | dijkstra " << single * 1000 << " us/query"
+              << " | frontier " << pareto * 1000 << " us/query (x" << pareto / single << ", avg "
+              << double(frontierSize) / pairs.size() << " routes)" << (sink == 42 ? " " : "") << std::endl;
+}
+
+// Compares contraction hierarchy queries against Dijkstra and the legacy O(V^2) shortestPath
+void benchmarkContraction(int airportCount) {
+    Graph g = makeSyntheticGraph(airportCount, 8, 5);
+    FrozenGraph frozen = g.freeze();
+    ContractionHierarchy ch;
+    double buildMs = timeMs(1, [&] { ch.build(frozen); });
+    std::stringstream stored;
+    ch.save(stored);
+    size_t bytes = stored.str().size();
+    ContractionHierarchy loaded;
+    double loadMs = timeMs(1, [&] { loaded.load(stored, frozen); });
+
+    std::mt19937 rng(4);
+    std::uniform_int_distribution<int> pick(0, frozen.vertexCount() - 1);
+    std::vector<std::pair<int, int>> pairs(500);
+    for (auto& pair : pairs) pair = {pick(rng), pick(rng)};
+
+    long long sink = 0;
+    int mismatches = 0;
+    size_t i = 0;
+    double dijkstraUs = 1000 * timeMs(static_cast<int>(pairs.size()), [&] {
+        sink += frozen.shortestRoute(pairs[i].first, pairs[i].second).distance;
+        i = (i + 1) % pairs.size();
+    });
+    double chUs = 1000 * timeMs(static_cast<int>(pairs.size()), [&] {
+        sink += loaded.route(pairs[i].first, pairs[i].second).distance;
+        i = (i + 1) % pairs.size();
+    });
+    double legacyUs = 1000 * timeMs(2, [&] { sink += legacyShortestDistance(g, pairs[i].first, pairs[i].second); i++; });
+    for (const auto& pair : pairs) {
+        RouteResult a = frozen.shortestRoute(pair.first, pair.second);
+        RouteResult b = loaded.route(pair.first, pair.second);
+        if (a.found != b.found || a.distance != b.distance) mismatches++;
+    }
+
+    std::cout << "contraction V=" << frozen.vertexCount() << " | build " << buildMs << " ms, " << ch.arcCount() << " arcs, "
+              << bytes / 1024 << " KiB, load " << loadMs << " ms | query " << chUs << " us vs dijkstra " << dijkstraUs
+              << " us (x" << dijkstraUs / chUs << ") vs legacy shortestPath " << legacyUs << " us (x" << legacyUs / chUs << ")"
+              << (mismatches ? " MISMATCHES " + std::to_string(mismatches) : "") << (sink == 42 ? " " : "") << std::endl;
+}
+
+// Compares rebuilding a graph from rows against opening a mapped binary snapshot of it
+void benchmarkSnapshot(int airportCount) {
+    Graph g;
+    double buildMs = timeMs(1, [&] { g = makeSyntheticGraph(airportCount, 8, 9); });
+    FrozenGraph frozen;
+    double freezeMs = timeMs(1, [&] { frozen = g.freeze(); });
+    std::string path = "benchmark_snapshot.bin";
+    double writeMs = timeMs(1, [&] { GraphSnapshot::write(path, frozen); });
+
+    GraphSnapshot snapshot;
+    bool opened = false;
+    double openMs = timeMs(5, [&] { opened = snapshot.open(path, false); });
+    double verifiedMs = timeMs(5, [&] { opened = snapshot.open(path, true) && opened; });
+    bool same = opened && snapshot.graph().shortestRoute(0, airportCount - 1).distance == frozen.shortestRoute(0, airportCount - 1).distance;
+    std::remove(path.c_str());
+
+    std::cout << "snapshot V=" << frozen.vertexCount() << " E=" << frozen.edgeCount() << " | build from rows " << buildMs
+              << " ms + freeze " << freezeMs << " ms | write " << writeMs << " ms | open " << openMs << " ms, verified "
+              << verifiedMs << " ms" << (same ? "" : " MISMATCH") << std::endl;
+}
+
+// Parses route text the way loadTXT did before the parallel loader (stringstream and getline per field)
+void legacyLoad(const std::string& text, Graph& g) {
+    std::istringstream file(text);
+    std::string line;
+    getline(file, line);
+    while (getline(file, line)) {
+        std::stringstream ss(line);
+        std::string origin, dest, originCity, originState, destCity, destState, distStr, costStr;
+        getline(ss, origin, ',');
+        getline(ss, dest, ',');
+        if (ss.peek() == '"') ss.ignore();
+        getline(ss, originCity, ',');
+        if (ss.peek() == ' ') ss.ignore();
+        getline(ss, originState, '"');
+        ss.ignore(1, ',');
+        if (ss.peek() == '"') ss.ignore();
+        getline(ss, destCity, ',');
+        if (ss.peek() == ' ') ss.ignore();
+        getline(ss, destState, '"');
+        ss.ignore(1, ',');
+        getline(ss, distStr, ',');
+        getline(ss, costStr, ',');
+        g.addAirport(origin, originState);
+        g.addAirport(dest, destState);
+        g.addFlight(origin, dest, std::stoi(distStr), std::stoi(costStr));
+    }
+}
+
+// Compares the parallel loader against the legacy line-by-line parser on generated route text
+void benchmarkLoader(int airportCount) {
+    FrozenGraph source = makeSyntheticGraph(airportCount, 8, 13).freeze();
+    std::string text = "Origin_airport,Destination_airport,Origin_city,Destination_city,Distance,Cost\n";
+    for (int u = 0; u < source.vertexCount(); ++u) {
+        for (int e = source.edgeBegin(u); e < source.edgeEnd(u); ++e) {
+            int v = source.edgeTarget(e);
+            text += source.getAirportCode(u) + "," + source.getAirportCode(v) + ",\"City " + std::to_string(u) + ", " + std::string(source.getState(u)) +
+                    "\",\"City " + std::to_string(v) + ", " + std::string(source.getState(v)) + "\"," + std::to_string(source.edgeDistance(e)) + "," +
+                    std::to_string(source.edgeCost(e)) + "\n";
+        }
+    }
+    double megabytes = text.size() / 1e6;
+
+    Graph legacy;
+    double legacyMs = timeMs(1, [&] { legacyLoad(text, legacy); });
+    std::cout << "loader " << megabytes << " MB, " << source.edgeCount() << " rows | legacy " << megabytes / (legacyMs / 1000) << " MB/s";
+    for (int threads : {1, 4}) {
+        Graph g;
+        LoadReport report;
+        double ms = timeMs(1, [&] { report = loadFlightsText(text.data(), text.size(), g, threads); });
+        std::cout << " | " << threads << " thread(s) " << megabytes / (ms / 1000) << " MB/s"
+                  << (report.rows == static_cast<size_t>(source.edgeCount()) && report.errors.empty() ? "" : " ROW MISMATCH");
+    }
+    std::cout << std::endl;
+}
+
+// Measures batched query throughput as the pool grows
+void benchmarkBatch(int airportCount) {
+    FrozenGraph frozen = makeSyntheticGraph(airportCount, 8, 17).freeze();
+    std::mt19937 rng(6);
+    std::uniform_int_distribution<int> pick(0, frozen.vertexCount() - 1);
+    std::uniform_int_distribution<int> originPick(0, 199); // Repeated origins, as in production batches
+    std::vector<RouteQuery> queries(20000);
+    for (auto& query : queries) query = {originPick(rng) * (frozen.vertexCount() / 200), pick(rng)};
+
+    std::cout << "batch V=" << frozen.vertexCount() << " " << queries.size() << " queries";
+    double baseline = 0;
+    for (int threads : {1, 2, 4, 8}) {
+        ThreadPool pool(threads);
+        double ms = timeMs(1, [&] { batchShortestRoutes(frozen, queries, pool); });
+        if (threads == 1) baseline = ms;
+        std::cout << " | " << threads << " thread(s) " << queries.size() / (ms / 1000) << " q/s (x" << baseline / ms << ")";
+    }
+    std::cout << std::endl;
+}
+
+// Compares the Floyd-Warshall and per-source Dijkstra table builds and measures table lookups against Dijkstra
+void benchmarkAllPairs(int airportCount) {
+    FrozenGraph frozen = makeSyntheticGraph(airportCount, 8, 19).freeze();
+    ThreadPool pool;
+    std::cout << "allpairs V=" << frozen.vertexCount();
+    AllPairsTable table;
+    for (AllPairsTable::Method method : {AllPairsTable::Method::FloydWarshall, AllPairsTable::Method::Dijkstra}) {
+        AllPairsTable::BuildStats stats = table.build(frozen, pool, Metric::Distance, method);
+        std::cout << " | " << (method == AllPairsTable::Method::FloydWarshall ? "floyd-warshall " : "dijkstra ")
+                  << stats.milliseconds << " ms " << stats.bytes / (1024 * 1024) << " MiB";
+    }
+
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> pick(0, frozen.vertexCount() - 1);
+    std::vector<std::pair<int, int>> pairs(100000);
+    for (auto& pair : pairs) pair = {pick(rng), pick(rng)};
+    long long checksum = 0;
+    double lookupMs = timeMs(1, [&] {
+        for (const auto& pair : pairs) checksum += table.distance(pair.first, pair.second);
+    });
+    double dijkstraMs = timeMs(1, [&] {
+        for (int i = 0; i < 1000; ++i) checksum += frozen.shortestRoute(pairs[i].first, pairs[i].second).distance;
+    });
+    std::cout << " | lookup " << lookupMs * 1e6 / pairs.size() << " ns vs dijkstra " << dijkstraMs * 1e6 / 1000 << " ns"
+              << (checksum == 0 ? " (empty)" : "") << std::endl;
+}
+
+// Kruskal as it ran before the spanning forest engines: selection sort and a union-find without path compression
+long long legacyKruskalWeight(const FrozenGraph& g) {
+    struct EdgeInfo {
+        int u;
+        int v;
+        int cost;
+    };
+    std::vector<EdgeInfo> allEdges;
+    for (int u = 0; u < g.vertexCount(); ++u) {
+        for (int e = g.edgeBegin(u); e < g.edgeEnd(u); ++e) {
+            if (u != g.edgeTarget(e)) allEdges.push_back({u, g.edgeTarget(e), g.edgeCost(e)});
+        }
+    }
+    for (size_t i = 0; i + 1 < allEdges.size(); ++i) {
+        size_t minIdx = i;
+        for (size_t j = i + 1; j < allEdges.size(); ++j) {
+            if (allEdges[j].cost < allEdges[minIdx].cost) minIdx = j;
+        }
+        std::swap(allEdges[i], allEdges[minIdx]);
+    }
+    std::vector<int> parent(g.vertexCount());
+    for (int i = 0; i < g.vertexCount(); ++i) parent[i] = i;
+    auto find = [&](int x) {
+        while (x != parent[x]) x = parent[x];
+        return x;
+    };
+    long long total = 0;
+    for (const auto& edge : allEdges) {
+        int rootX = find(edge.u), rootY = find(edge.v);
+        if (rootX == rootY) continue;
+        parent[rootY] = rootX;
+        total += edge.cost;
+    }
+    return total;
+}
+
+// Compares the Prim, Kruskal and Boruvka spanning forest engines (and the legacy Kruskal on small graphs)
+void benchmarkSpanning(int airportCount) {
+    FrozenGraph frozen = makeSyntheticGraph(airportCount, 8, 23).freeze();
+    std::cout << "spanning V=" << frozen.vertexCount() << " E=" << frozen.edgeCount();
+    SpanningForest reference;
+    double primMs = timeMs(1, [&] { reference = primForest(frozen); });
+    std::cout << " | prim " << primMs << " ms";
+    SpanningForest forest;
+    double kruskalMs = timeMs(1, [&] { forest = kruskalForest(frozen); });
+    std::cout << " | kruskal " << kruskalMs << " ms" << (forest.weight == reference.weight ? "" : " MISMATCH");
+    for (int threads : {1, 4}) {
+        ThreadPool pool(threads);
+        double boruvkaMs = timeMs(1, [&] { forest = boruvkaForest(frozen, pool); });
+        std::cout << " | boruvka " << threads << " thread(s) " << boruvkaMs << " ms" << (forest.weight == reference.weight ? "" : " MISMATCH");
+    }
+    if (frozen.edgeCount() <= 40000) {
+        long long legacyWeight = 0;
+        double legacyMs = timeMs(1, [&] { legacyWeight = legacyKruskalWeight(frozen); });
+        std::cout << " | legacy kruskal " << legacyMs << " ms" << (legacyWeight == reference.weight ? "" : " MISMATCH");
+    }
+    std::cout << " | " << reference.trees.size() << " tree(s), weight " << reference.weight << std::endl;
+}
+
+// Builds the undirected graph the way createUndirectedGraph did before: a reverse-edge scan per flight and
+// one addFlight call per direction
+Graph legacyUndirectedGraph(const Graph& g) {
+    int n = g.airportCount();
+    Graph undirectedGraph;
+    for (int v = 0; v < n; ++v) {
+        undirectedGraph.addAirport(g.getAirportCode(v), std::string(g.getState(v)));
+    }
+    for (int u = 0; u < n; ++u) {
+        for (const auto& edge : g.getFlights(u)) {
+            int v = edge.destIndex;
+            int reverseCost = -1;
+            for (const auto& revEdge : g.getFlights(v)) {
+                if (revEdge.destIndex == u) {
+                    reverseCost = revEdge.cost;
+                    break;
+                }
+            }
+            if (u < v) {
+                int minCost = (reverseCost != -1) ? std::min(edge.cost, reverseCost) : edge.cost;
+                undirectedGraph.addFlight(g.getAirportCode(u), g.getAirportCode(v), 0, minCost);
+                undirectedGraph.addFlight(g.getAirportCode(v), g.getAirportCode(u), 0, minCost);
+            }
+        }
+    }
+    return undirectedGraph;
+}
+
+// Compares the CSR-based undirected construction against the legacy one, and the cached view against both
+void benchmarkUndirected(int airportCount) {
+    Graph g = makeSyntheticGraph(airportCount, 8, 29);
+    g.createUndirectedGraph(); // Warms the CSR snapshot the query methods share
+    std::cout << "undirected V=" << airportCount;
+    double legacyMs = timeMs(3, [&] { legacyUndirectedGraph(g); });
+    double buildMs = timeMs(3, [&] { g.createUndirectedGraph(); });
+    g.undirectedView();
+    double cachedMs = timeMs(100, [&] { g.undirectedView(); });
+    std::cout << " | legacy " << legacyMs << " ms | csr " << buildMs << " ms (x" << legacyMs / buildMs << ")"
+              << " | cached view " << cachedMs * 1000 << " us" << std::endl;
+}
+
+// Ranks airports by total connections the way printFlightConnections did before the degree index:
+// a full inbound pass and a selection sort (only the first k positions, so it finishes at large sizes)
+std::vector<int> legacyTopHubs(const Graph& g, size_t k) {
+    int n = g.airportCount();
+    std::vector<int> total(n, 0);
+    for (int i = 0; i < n; ++i) {
+        total[i] += g.getFlights(i).size();
+        for (const auto& edge : g.getFlights(i)) total[edge.destIndex]++;
+    }
+    std::vector<int> order(n);
+    for (int i = 0; i < order.size(); ++i) order[i] = i;
+    for (size_t i = 0; i < k && i + 1 < order.size(); ++i) {
+        size_t maxIdx = i;
+        for (size_t j = i + 1; j < order.size(); ++j) {
+            if (total[order[j]] > total[order[maxIdx]]) maxIdx = j;
+        }
+        std::swap(order[i], order[maxIdx]);
+    }
+    order.resize(std::min(k, order.size()));
+    return order;
+}
+
+// Compares top-k hub queries on the incremental degree index against a full rescan
+void benchmarkHubs(int airportCount) {
+    Graph g = makeSyntheticGraph(airportCount, 8, 31);
+    const size_t k = 20;
+    std::vector<int> legacy;
+    double legacyMs = timeMs(1, [&] { legacy = legacyTopHubs(g, k); });
+    std::vector<std::pair<std::string, int>> hubs;
+    double indexMs = timeMs(1000, [&] { hubs = g.topHubs(k); });
+    bool same = hubs.size() == legacy.size();
+    for (size_t i = 0; same && i < hubs.size(); ++i) {
+        same = hubs[i].second == g.degreeIndex().degree(legacy[i]);
+    }
+    std::cout << "hubs V=" << airportCount << " top " << k << " | rescan " << legacyMs << " ms | index "
+              << indexMs * 1000 << " us" << (same ? "" : " MISMATCH") << std::endl;
+}
+
+// Compares landmark-guided A* against bidirectional Dijkstra: preprocessing cost, query time and settled airports
+void benchmarkLandmarks(int airportCount, int landmarkCount) {
+    FrozenGraph plain = makeSyntheticGraph(airportCount, 8, 37).freeze();
+    FrozenGraph guided = plain;
+    ThreadPool pool;
+    auto index = std::make_shared<LandmarkIndex>();
+    double buildMs = timeMs(1, [&] { index->build(plain, pool, landmarkCount); });
+    guided.attachLandmarks(index);
+
+    std::mt19937 rng(8);
+    std::uniform_int_distribution<int> pick(0, plain.vertexCount() - 1);
+    std::vector<std::pair<int, int>> pairs(500);
+    for (auto& pair : pairs) pair = {pick(rng), pick(rng)};
+
+    std::cout << "landmarks V=" << plain.vertexCount() << " L=" << landmarkCount << " build " << buildMs << " ms "
+              << index->memoryBytes() / (1024 * 1024) << " MiB";
+    for (Metric metric : {Metric::Distance, Metric::Cost}) {
+        long long plainSettled = 0, guidedSettled = 0;
+        bool same = true;
+        double plainMs = timeMs(1, [&] {
+            for (const auto& pair : pairs) {
+                SearchStats stats;
+                plain.shortestRoute(pair.first, pair.second, metric, &stats);
+                plainSettled += stats.settled;
+            }
+        });
+        std::vector<RouteResult> routes;
+        double guidedMs = timeMs(1, [&] {
+            for (const auto& pair : pairs) {
+                SearchStats stats;
+                routes.push_back(guided.shortestRoute(pair.first, pair.second, metric, &stats));
+                guidedSettled += stats.settled;
+            }
+        });
+        for (size_t i = 0; i < pairs.size(); ++i) {
+            RouteResult reference = plain.shortestRoute(pairs[i].first, pairs[i].second, metric);
+            same = same && routes[i].found == reference.found &&
+                   (metric == Metric::Distance ? routes[i].distance == reference.distance : routes[i].cost == reference.cost);
+        }
+        std::cout << " | " << (metric == Metric::Distance ? "distance" : "cost") << " bidirectional " << plainMs * 1000 / pairs.size()
+                  << " us " << plainSettled / pairs.size() << " settled, alt " << guidedMs * 1000 / pairs.size() << " us "
+                  << guidedSettled / pairs.size() << " settled" << (same ? "" : " MISMATCH");
+    }
+    std::cout << std::endl;
+}
+
+// Compares bidirectional Dijkstra against the one-directional search on the same pairs
+void benchmarkBidirectional(int airportCount) {
+    FrozenGraph frozen = makeSyntheticGraph(airportCount, 8, 41).freeze();
+    std::mt19937 rng(9);
+    std::uniform_int_distribution<int> pick(0, frozen.vertexCount() - 1);
+    std::vector<std::pair<int, int>> pairs(1000);
+    for (auto& pair : pairs) pair = {pick(rng), pick(rng)};
+
+    long long oneWaySettled = 0, bothWaysSettled = 0;
+    std::vector<int> oneWayKeys;
+    double oneWayMs = timeMs(1, [&] {
+        RouteResult route;
+        SearchWorkspace& ws = SearchWorkspace::local();
+        for (const auto& pair : pairs) {
+            dijkstra(frozen, pair.first, pair.second, ws);
+            extractRoute(ws, pair.second, route);
+            oneWayKeys.push_back(route.found ? route.distance : -1);
+            oneWaySettled += ws.settledCount();
+        }
+    });
+    bool same = true;
+    double bothWaysMs = timeMs(1, [&] {
+        for (size_t i = 0; i < pairs.size(); ++i) {
+            SearchStats stats;
+            RouteResult route = frozen.shortestRoute(pairs[i].first, pairs[i].second, Metric::Distance, &stats);
+            same = same && (route.found ? route.distance : -1) == oneWayKeys[i];
+            bothWaysSettled += stats.settled;
+        }
+    });
+    std::cout << "bidirectional V=" << frozen.vertexCount() << " | dijkstra " << oneWayMs * 1000 / pairs.size() << " us "
+              << oneWaySettled / pairs.size() << " settled | bidirectional " << bothWaysMs * 1000 / pairs.size() << " us "
+              << bothWaysSettled / pairs.size() << " settled" << (same ? "" : " MISMATCH") << std::endl;
+}
+
+// Compares a full single-source search against the state-indexed early-stopping search for routes into a
+// small state of five regional airports served from the first hub
+void benchmarkStateSearch(int airportCount) {
+    Graph g = makeSyntheticGraph(airportCount, 8, 47);
+    for (int i = 0; i < 5; ++i) {
+        std::string code = "RG" + std::to_string(i);
+        g.addAirport(code, "SMALL");
+        g.addFlight("AAA", code, 150 + i * 20, 60);
+    }
+    FrozenGraph frozen = g.freeze();
+    std::mt19937 rng(23);
+    std::uniform_int_distribution<int> pick(0, frozen.vertexCount() - 1);
+    std::vector<int> origins(200);
+    for (int& origin : origins) origin = pick(rng);
+
+    long long fullSettled = 0, earlySettled = 0, fullRoutes = 0, earlyRoutes = 0;
+    double fullMs = timeMs(1, [&] {
+        SearchWorkspace& ws = SearchWorkspace::local();
+        RouteResult route;
+        for (int origin : origins) {
+            dijkstra(frozen, origin, -1, ws);
+            for (int v = 0; v < frozen.vertexCount(); ++v) {
+                if (frozen.getState(v) == "SMALL" && extractRoute(ws, v, route)) fullRoutes++;
+            }
+            fullSettled += ws.settledCount();
+        }
+    });
+    double earlyMs = timeMs(1, [&] {
+        for (int origin : origins) {
+            SearchStats stats;
+            earlyRoutes += frozen.shortestRoutesToState(origin, "SMALL", Metric::Distance, &stats).size();
+            earlySettled += stats.settled;
+        }
+    });
+    std::cout << "state search V=" << frozen.vertexCount() << " | full " << fullMs * 1000 / origins.size() << " us "
+              << fullSettled / origins.size() << " settled | indexed " << earlyMs * 1000 / origins.size() << " us "
+              << earlySettled / origins.size() << " settled" << (fullRoutes == earlyRoutes ? "" : " MISMATCH") << std::endl;
+}
+
+// Replays a skewed workload over 500 popular routes with and without the query cache
+void benchmarkCache(int airportCount) {
+    FrozenGraph plain = makeSyntheticGraph(airportCount, 8, 43).freeze();
+    FrozenGraph cached = plain;
+    auto cache = std::make_shared<QueryCache>();
+    cached.attachCache(cache);
+
+    std::mt19937 rng(17);
+    std::uniform_int_distribution<int> pick(0, plain.vertexCount() - 1);
+    std::vector<std::pair<int, int>> popular(500);
+    for (auto& pair : popular) pair = {pick(rng), pick(rng)};
+    std::uniform_real_distribution<double> skew(0.0, 1.0);
+    std::vector<int> workload(20000);
+    for (int& query : workload) query = static_cast<int>(skew(rng) * skew(rng) * popular.size()); // Favours the first routes
+
+    long long plainTotal = 0, cachedTotal = 0;
+    double plainMs = timeMs(1, [&] {
+        for (int query : workload) plainTotal += plain.shortestRoute(popular[query].first, popular[query].second).distance;
+    });
+    double cachedMs = timeMs(1, [&] {
+        for (int query : workload) cachedTotal += cached.shortestRoute(popular[query].first, popular[query].second).distance;
+    });
+    QueryCache::Stats stats = cache->stats();
+    std::cout << "cache V=" << plain.vertexCount() << " | uncached " << plainMs * 1000 / workload.size() << " us | cached "
+              << cachedMs * 1000 / workload.size() << " us | hits " << stats.hits << " misses " << stats.misses << " entries "
+              << stats.entries << " (" << stats.bytes / 1024 << " KB)" << (plainTotal == cachedTotal ? "" : " MISMATCH")
+              << std::endl;
+}
+
+// Measures what instrumentation costs per query: metrics off (uninstrumented searches), metrics on (counting
+// searches, clock reads and per-thread recording), then dumps the collected metrics' size
+void benchmarkInstrumentation(int airportCount) {
+    FrozenGraph frozen = makeSyntheticGraph(airportCount, 8, 53).freeze();
+    std::mt19937 rng(29);
+    std::uniform_int_distribution<int> pick(0, frozen.vertexCount() - 1);
+    std::vector<std::pair<int, int>> pairs(2000);
+    for (auto& pair : pairs) pair = {pick(rng), pick(rng)};
+
+    QueryMetrics& metrics = QueryMetrics::global();
+    long long offTotal = 0, onTotal = 0;
+    metrics.enable(false);
+    double offMs = timeMs(1, [&] {
+        for (const auto& pair : pairs) offTotal += frozen.shortestRoute(pair.first, pair.second).distance;
+    });
+    metrics.reset();
+    metrics.enable(true);
+    double onMs = timeMs(1, [&] {
+        for (const auto& pair : pairs) onTotal += frozen.shortestRoute(pair.first, pair.second).distance;
+    });
+    metrics.enable(false);
+    std::cout << "instrumentation V=" << frozen.vertexCount() << " | off " << offMs * 1000 / pairs.size() << " us | on "
+              << onMs * 1000 / pairs.size() << " us | json " << metrics.toJson().size() << " B, prometheus "
+              << metrics.toPrometheus().size() << " B" << (offTotal == onTotal ? "" : " MISMATCH") << std::endl;
+    metrics.reset();
+}
+
+// Returns the bytes currently allocated from the heap (glibc)
+size_t heapBytes() {
+    return mallinfo2().uordblks;
+}
+
+// Compares per-airport memory and code lookups of the old Vertex layout (three strings per airport plus a
+// string-keyed hash map) against AirportMetadata. Adjacency is left out of both, so only metadata is counted
+void benchmarkMetadata(int airportCount) {
+    struct LegacyVertex {
+        std::string airportCode;
+        std::string city;
+        std::string state;
+    };
+    std::vector<std::string> codes(airportCount), states(airportCount), cities(airportCount);
+    for (int i = 0; i < airportCount; ++i) {
+        codes[i] = syntheticCode(i);
+        states[i] = "ST" + std::to_string(i % 50);
+        cities[i] = "Synthetic City " + std::to_string(i % 2000); // Too long for the small-string buffer
+    }
+
+    size_t before = heapBytes();
+    std::vector<LegacyVertex> vertices;
+    std::unordered_map<std::string, int> index;
+    for (int i = 0; i < airportCount; ++i) {
+        vertices.push_back({codes[i], cities[i], states[i]});
+        index.emplace(codes[i], i);
+    }
+    size_t legacyBytes = heapBytes() - before;
+
+    before = heapBytes();
+    AirportMetadata airports;
+    for (int i = 0; i < airportCount; ++i) airports.insert(codes[i], states[i], cities[i]);
+    size_t compactBytes = heapBytes() - before;
+
+    long long legacySum = 0, compactSum = 0;
+    double legacyMs = timeMs(3, [&] {
+        for (const auto& code : codes) legacySum += index.find(code)->second;
+    });
+    double compactMs = timeMs(3, [&] {
+        for (const auto& code : codes) compactSum += airports.find(code);
+    });
+    std::cout << "metadata V=" << airportCount << " | legacy " << double(legacyBytes) / airportCount << " B/airport, "
+              << legacyMs * 1e6 / airportCount << " ns/lookup | compact " << double(compactBytes) / airportCount
+              << " B/airport (reported " << double(airports.memoryBytes()) / airportCount << "), "
+              << compactMs * 1e6 / airportCount << " ns/lookup" << (legacySum == compactSum ? "" : " MISMATCH") << std::endl;
+}
+
+// Synthetic airline network for the regression suite. Airports are scattered over a 3000 x 1500 mile map cut
+// into 50 square states. Popularity follows a Zipf law, and each airport's flight count follows its popularity,
+// so a few hubs carry most flights and most airports are spokes with one or two. Flights mostly go to popular
+// airports, and nine in ten have a return leg. Distance is the straight-line distance and cost rises with it
+struct AirlineNetwork {
+    struct Flight {
+        int origin;
+        int dest;
+        int distance;
+        int cost;
+    };
+
+    std::vector<std::string> codes;
+    std::vector<std::string> states;
+    std::vector<Flight> flights;
+};
+
+AirlineNetwork makeAirlineNetwork(int airportCount, unsigned seed) {
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    AirlineNetwork net;
+    std::vector<double> x(airportCount), y(airportCount), popularity(airportCount);
+    double total = 0;
+    for (int i = 0; i < airportCount; ++i) {
+        x[i] = unit(rng) * 3000;
+        y[i] = unit(rng) * 1500;
+        net.codes.push_back(syntheticCode(i));
+        net.states.push_back("S" + std::to_string(static_cast<int>(x[i] / 300) + 10 * static_cast<int>(y[i] / 300)));
+        total += 1.0 / (i + 1);
+        popularity[i] = total; // Running sum, for sampling by popularity
+    }
+
+    auto popular = [&] {
+        return static_cast<int>(std::upper_bound(popularity.begin(), popularity.end(), unit(rng) * total) - popularity.begin());
+    };
+    auto addFlight = [&](int from, int to) {
+        int distance = std::max(50, static_cast<int>(std::hypot(x[from] - x[to], y[from] - y[to])));
+        int cost = 40 + static_cast<int>(distance * (0.08 + 0.04 * unit(rng)));
+        net.flights.push_back({from, to, distance, cost});
+    };
+    for (int i = 0; i < airportCount; ++i) {
+        int flightCount = std::max(1, static_cast<int>(1.5 * airportCount / (i + 1) / total));
+        for (int f = 0; f < flightCount; ++f) {
+            int dest = (unit(rng) < 0.8) ? popular() : static_cast<int>(unit(rng) * airportCount);
+            if (dest == i) continue;
+            addFlight(i, dest);
+            if (unit(rng) < 0.9) addFlight(dest, i);
+        }
+    }
+    return net;
+}
+
+// Writes a network in the route-file format the loader reads
+std::string routeText(const AirlineNetwork& net) {
+    std::string text = "Origin_airport,Destination_airport,Origin_city,Destination_city,Distance,Cost\n";
+    for (const auto& flight : net.flights) {
+        text += net.codes[flight.origin] + "," + net.codes[flight.dest] + ",\"C" + std::to_string(flight.origin) + ", " +
+                net.states[flight.origin] + "\",\"C" + std::to_string(flight.dest) + ", " + net.states[flight.dest] + "\"," +
+                std::to_string(flight.distance) + "," + std::to_string(flight.cost) + "\n";
+    }
+    return text;
+}
+
+// Stream buffer that discards everything, swapped into std::cout so the printing operations run without I/O
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override { return c; }
+    std::streamsize xsputn(const char*, std::streamsize count) override { return count; }
+};
+
+// Times one call in microseconds
+template <typename F>
+double timeUs(F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+// Prints one suite result as a JSON line: nearest-rank latency percentiles of the samples and the throughput in
+// items per second, where every sample handled itemsPerSample items (rows loaded, queries answered, ...)
+void reportOperation(std::ostream& out, const AirlineNetwork& net, const char* operation, std::vector<double>& samplesUs,
+                     double itemsPerSample) {
+    std::sort(samplesUs.begin(), samplesUs.end());
+    auto percentile = [&](double p) { return samplesUs[std::min(samplesUs.size() - 1, static_cast<size_t>(p * samplesUs.size()))]; };
+    double totalUs = 0;
+    for (double sample : samplesUs) totalUs += sample;
+    out << "{\"airports\":" << net.codes.size() << ",\"flights\":" << net.flights.size() << ",\"op\":\"" << operation
+        << "\",\"samples\":" << samplesUs.size() << ",\"p50_us\":" << percentile(0.50) << ",\"p90_us\":" << percentile(0.90)
+        << ",\"p99_us\":" << percentile(0.99) << ",\"max_us\":" << samplesUs.back()
+        << ",\"throughput_per_s\":" << samplesUs.size() * itemsPerSample / (totalUs / 1e6) << "}" << std::endl;
+}
+
+// Runs every public Graph operation on a generated network and reports each as a JSON line. Printing operations
+// write into a discarding buffer, so the numbers cover the search and formatting work but no terminal I/O
+void benchmarkSuite(int airportCount, std::ostream& out) {
+    AirlineNetwork net = makeAirlineNetwork(airportCount, 2024);
+    int wholeGraphRuns = (airportCount >= 1000000) ? 2 : 5;
+    int queryRuns = (airportCount >= 1000000) ? 50 : 200;
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> airportPick(0, airportCount - 1);
+    std::uniform_int_distribution<int> statePick(0, 49);
+    std::uniform_int_distribution<int> stopsPick(1, 3);
+    std::vector<double> samples;
+
+    // Loading the route file text, whole-file samples
+    std::string text = routeText(net);
+    for (int run = 0; run < wholeGraphRuns; ++run) {
+        Graph loaded;
+        samples.push_back(timeUs([&] { loadFlightsText(text.data(), text.size(), loaded); }));
+    }
+    reportOperation(out, net, "load", samples, net.flights.size());
+    text.clear();
+    text.shrink_to_fit();
+    samples.clear();
+
+    // One flight at a time into a graph that already has its airports
+    Graph g;
+    g.reserve(airportCount);
+    for (int i = 0; i < airportCount; ++i) g.addAirport(net.codes[i], net.states[i]);
+    samples.reserve(net.flights.size());
+    for (const auto& flight : net.flights) {
+        samples.push_back(timeUs([&] { g.addFlight(net.codes[flight.origin], net.codes[flight.dest], flight.distance, flight.cost); }));
+    }
+    reportOperation(out, net, "addFlight", samples, 1);
+    samples.clear();
+
+    // The first query after a change builds the snapshot; it is timed on its own
+    samples.push_back(timeUs([&] { g.shortestPath(net.codes[0], net.codes[1]); }));
+    reportOperation(out, net, "firstQuery", samples, 1);
+    samples.clear();
+
+    for (int run = 0; run < queryRuns; ++run) {
+        const std::string& origin = net.codes[airportPick(rng)];
+        const std::string& dest = net.codes[airportPick(rng)];
+        samples.push_back(timeUs([&] { g.shortestPath(origin, dest); }));
+    }
+    reportOperation(out, net, "shortestPath", samples, 1);
+    samples.clear();
+
+    for (int run = 0; run < queryRuns; ++run) {
+        const std::string& origin = net.codes[airportPick(rng)];
+        std::string state = "S" + std::to_string(statePick(rng));
+        samples.push_back(timeUs([&] { g.shortestPathsToState(origin, state); }));
+    }
+    reportOperation(out, net, "shortestPathsToState", samples, 1);
+    samples.clear();
+
+    for (int run = 0; run < queryRuns; ++run) {
+        const std::string& origin = net.codes[airportPick(rng)];
+        const std::string& dest = net.codes[airportPick(rng)];
+        int stops = stopsPick(rng);
+        samples.push_back(timeUs([&] { g.shortestPathWithStops(origin, dest, stops); }));
+    }
+    reportOperation(out, net, "shortestPathWithStops", samples, 1);
+    samples.clear();
+
+    for (int run = 0; run < wholeGraphRuns; ++run) {
+        samples.push_back(timeUs([&] { g.createUndirectedGraph(); }));
+    }
+    reportOperation(out, net, "createUndirectedGraph", samples, 1);
+    samples.clear();
+
+    const Graph& undirected = g.undirectedView();
+    undirected.primMST(); // Builds the view's snapshot outside the timed runs
+    for (int run = 0; run < wholeGraphRuns; ++run) {
+        samples.push_back(timeUs([&] { undirected.primMST(); }));
+    }
+    reportOperation(out, net, "primMST", samples, 1);
+    samples.clear();
+
+    for (int run = 0; run < wholeGraphRuns; ++run) {
+        samples.push_back(timeUs([&] { undirected.kruskalMST(); }));
+    }
+    reportOperation(out, net, "kruskalMST", samples, 1);
+    samples.clear();
+
+    for (int run = 0; run < wholeGraphRuns; ++run) {
+        samples.push_back(timeUs([&] { g.printFlightConnections(); }));
+    }
+    reportOperation(out, net, "printFlightConnections", samples, 1);
+}
+
+// Runs the regression suite on networks of 10^3 up to maxAirports airports, reporting to the real stdout while the
+// operations print into a discarding buffer
+void runSuite(int maxAirports) {
+    NullBuffer sink;
+    std::streambuf* terminal = std::cout.rdbuf(&sink);
+    std::ostream out(terminal);
+    for (int airportCount = 1000; airportCount <= maxAirports; airportCount *= 10) {
+        benchmarkSuite(airportCount, out);
+    }
+    std::cout.rdbuf(terminal);
+}
+
+// Route query latency seen by reader threads while an update thread applies a burst of schedule changes, for the
+// query server's RCU snapshot swap against a reader-writer lock held while the writer updates and refreezes
+void benchmarkServer(int airportCount) {
+    const int readerCount = 3, queriesPerReader = 3000;
+    Graph source = makeSyntheticGraph(airportCount, 8, 61);
+    std::vector<std::pair<std::string, std::string>> flights; // Existing flights to toggle
+    for (int v = 0; v < source.airportCount() && flights.size() < 200; v += 7) {
+        if (!source.getFlights(v).empty()) {
+            flights.push_back({source.getAirportCode(v), source.getAirportCode(source.getFlights(v)[0].destIndex)});
+        }
+    }
+
+    // Runs the readers (with or without the updater going) and prints their latency percentiles
+    auto measure = [&](const char* label, bool updating, const std::function<void(int, int, int)>& query,
+                       const std::function<void(int)>& update) {
+        std::atomic<bool> readersDone{false};
+        std::atomic<int> updates{0};
+        std::thread updater([&] {
+            for (int i = 0; updating && !readersDone; ++i) {
+                update(i);
+                updates++;
+            }
+        });
+        std::vector<std::vector<double>> samples(readerCount);
+        std::vector<std::thread> readers;
+        for (int r = 0; r < readerCount; ++r) {
+            readers.emplace_back([&, r] {
+                std::mt19937 rng(r + 1);
+                std::uniform_int_distribution<int> pick(0, airportCount - 1);
+                for (int q = 0; q < queriesPerReader; ++q) {
+                    int origin = pick(rng), destination = pick(rng);
+                    samples[r].push_back(timeUs([&] { query(r, origin, destination); }));
+                }
+            });
+        }
+        for (auto& reader : readers) reader.join();
+        readersDone = true;
+        updater.join();
+
+        std::vector<double> all;
+        for (const auto& s : samples) all.insert(all.end(), s.begin(), s.end());
+        std::sort(all.begin(), all.end());
+        std::cout << "server V=" << airportCount << " | " << label << (updating ? " updating" : " quiet") << " | p50 "
+                  << all[all.size() / 2] << " us p99 " << all[all.size() * 99 / 100] << " us max " << all.back() << " us | "
+                  << updates << " updates" << std::endl;
+    };
+
+    {
+        QueryServer server(source, readerCount + 1);
+        auto query = [&](int r, int origin, int destination) {
+            server.handle("route " + syntheticCode(origin) + " " + syntheticCode(destination), r);
+        };
+        auto update = [&](int i) {
+            const auto& flight = flights[i % flights.size()];
+            if ((i / flights.size()) % 2 == 0) {
+                server.handle("remove " + flight.first + " " + flight.second, readerCount);
+            } else {
+                server.handle("flight " + flight.first + " " + flight.second + " 500 100", readerCount);
+            }
+        };
+        measure("rcu", false, query, update);
+        measure("rcu", true, query, update);
+    }
+
+    Graph locked = source;
+    FrozenGraph lockedSnapshot = locked.freeze();
+    std::shared_mutex lock;
+    auto query = [&](int, int origin, int destination) { // Same lookups and reply text as the server's route command
+        std::shared_lock<std::shared_mutex> guard(lock);
+        RouteResult route = lockedSnapshot.shortestRoute(lockedSnapshot.getAirportIndex(syntheticCode(origin)),
+                                                         lockedSnapshot.getAirportIndex(syntheticCode(destination)));
+        std::string reply;
+        for (int v : route.path) reply += lockedSnapshot.getAirportCode(v) + "-";
+    };
+    auto update = [&](int i) {
+        const auto& flight = flights[i % flights.size()];
+        std::unique_lock<std::shared_mutex> guard(lock);
+        if ((i / flights.size()) % 2 == 0) {
+            locked.removeFlight(flight.first, flight.second);
+        } else {
+            locked.addFlight(flight.first, flight.second, 500, 100);
+        }
+        lockedSnapshot = locked.freeze();
+    };
+    measure("rwlock", false, query, update);
+    measure("rwlock", true, query, update);
+}
+
+// Generates a uniformly random network in which every airport has the given number of outbound flights
+Graph makeDenseGraph(int airportCount, int flightsPerAirport, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> anyPick(0, airportCount - 1);
+    std::uniform_int_distribution<int> distancePick(100, 3000);
+    std::vector<Graph::FlightRecord> rows;
+    rows.reserve(static_cast<size_t>(airportCount) * flightsPerAirport);
+    for (int i = 0; i < airportCount; ++i) {
+        for (int j = 0; j < flightsPerAirport; ++j) {
+            int distance = distancePick(rng);
+            int dest = anyPick(rng);
+            rows.push_back({syntheticCode(i), "S" + std::to_string(i % 50), syntheticCode(dest), "S" + std::to_string(dest % 50),
+                            distance, distance / 4 + distancePick(rng) / 10, "", ""});
+        }
+    }
+    Graph g;
+    g.addFlights(rows);
+    return g;
+}
+
+// Compares the dense O(V^2) engine (with each kernel set the CPU supports) against the heap engines on random
+// networks of increasing density: full single-source searches, point-to-point queries (bidirectional heap) and
+// Prim. "auto" is the engine the library picks for that graph
+void benchmarkDense(int airportCount) {
+    for (int flightsPerAirport : {airportCount / 128, airportCount / 32, airportCount / 8}) {
+        FrozenGraph frozen = makeDenseGraph(airportCount, std::max(1, flightsPerAirport), 59).freeze();
+        DenseMatrix matrix, undirected;
+        matrix.build(frozen, Metric::Distance);
+        undirected.buildUndirected(frozen, Metric::Cost);
+        std::mt19937 rng(31);
+        std::uniform_int_distribution<int> pick(0, frozen.vertexCount() - 1);
+        std::vector<std::pair<int, int>> pairs(200);
+        for (auto& pair : pairs) pair = {pick(rng), pick(rng)};
+        const int sources = 50;
+
+        long long heapTotal = 0;
+        bool same = true;
+        SearchWorkspace& ws = SearchWorkspace::local();
+        double heapMs = timeMs(1, [&] {
+            for (int s = 0; s < sources; ++s) dijkstra(frozen, pairs[s].first, -1, ws);
+        });
+        RouteResult route;
+        double bidirectionalMs = timeMs(1, [&] {
+            for (const auto& pair : pairs) {
+                bidirectionalDijkstra(frozen, pair.first, pair.second, ws, SearchWorkspace::local(1), route);
+                heapTotal += route.found ? route.distance : -1;
+            }
+        });
+        std::cout << "dense V=" << frozen.vertexCount() << " E=" << frozen.edgeCount() << " (" << matrix.memoryBytes() / (1024 * 1024)
+                  << " MiB, auto " << (frozen.denseMatrix(Metric::Distance) ? "dense" : "heap") << ") | heap search "
+                  << heapMs * 1000 / sources << " us, route " << bidirectionalMs * 1000 / pairs.size() << " us";
+
+        DenseIsa best = denseIsa();
+        for (DenseIsa isa : {DenseIsa::Scalar, DenseIsa::Sse41, DenseIsa::Avx2}) {
+            if (!useDenseIsa(isa)) continue;
+            DenseWorkspace& dense = DenseWorkspace::local();
+            long long total = 0;
+            double searchMs = timeMs(1, [&] {
+                for (int s = 0; s < sources; ++s) denseDijkstra(matrix, pairs[s].first, -1, dense);
+            });
+            double routeMs = timeMs(1, [&] {
+                for (const auto& pair : pairs) {
+                    denseDijkstra(matrix, pair.first, pair.second, dense);
+                    extractDenseRoute(matrix, dense, pair.second, route);
+                    total += route.found ? route.distance : -1;
+                }
+            });
+            std::vector<int> order;
+            double primMs = timeMs(3, [&] { densePrim(undirected, dense, order); });
+            same = same && total == heapTotal;
+            std::cout << " | " << denseIsaName(isa) << " search " << searchMs * 1000 / sources << " us, route "
+                      << routeMs * 1000 / pairs.size() << " us, prim " << primMs << " ms";
+        }
+        useDenseIsa(best);
+        double primMs = timeMs(3, [&] { primForest(frozen); });
+        std::cout << " | prim auto " << primMs << " ms" << (same ? "" : " MISMATCH") << std::endl;
+    }
+}
+
+// Compares the sequential single-source Dijkstra (the search behind the state queries) against delta-stepping on
+// 1, 4, 16 and 64 threads at the default bucket width, then narrower and wider buckets on 4 threads. Threads beyond
+// the hardware's only add contention, so the speedups depend on the machine the benchmark runs on
+void benchmarkDeltaStepping(int airportCount) {
+    FrozenGraph frozen = makeSyntheticGraph(airportCount, 8, 61).freeze();
+    std::mt19937 rng(17);
+    std::uniform_int_distribution<int> pick(0, frozen.vertexCount() - 1);
+    std::vector<int> sources(4);
+    for (int& source : sources) source = pick(rng);
+
+    SearchWorkspace& ws = SearchWorkspace::local();
+    double dijkstraMs = timeMs(1, [&] {
+        for (int source : sources) dijkstra(frozen, source, -1, ws);
+    }) / sources.size();
+    std::cout << "delta-stepping V=" << frozen.vertexCount() << " E=" << frozen.edgeCount() << " ("
+              << std::thread::hardware_concurrency() << " hardware threads) | dijkstra " << dijkstraMs << " ms";
+
+    // ws now holds the last source's labels; every run below ends on that source too. Besides equal keys, every
+    // reached airport but the source needs a reached parent with a flight into it weighing the key difference
+    DeltaStepping search;
+    auto matches = [&] {
+        for (int v = 0; v < frozen.vertexCount(); ++v) {
+            if (ws.reached(v) != search.reached(v)) return false;
+            if (!ws.reached(v)) continue;
+            if (ws.key(v) != search.key(v)) return false;
+            if (v == sources.back()) continue;
+            int parent = search.parent(v);
+            if (parent < 0 || parent >= frozen.vertexCount() || !search.reached(parent)) return false;
+            bool flight = false;
+            for (int e = frozen.edgeBegin(parent); e < frozen.edgeEnd(parent) && !flight; ++e) {
+                flight = frozen.edgeTarget(e) == v && frozen.edgeDistance(e) == search.key(v) - search.key(parent);
+            }
+            if (!flight) return false;
+        }
+        return true;
+    };
+    int width = DeltaStepping::defaultDelta(frozen, Metric::Distance);
+    for (int threads : {1, 4, 16, 64}) {
+        ThreadPool pool(threads);
+        double ms = timeMs(1, [&] {
+            for (int source : sources) search.run(frozen, source, pool, Metric::Distance, width);
+        }) / sources.size();
+        std::cout << " | " << threads << " thread(s) " << ms << " ms (" << dijkstraMs / ms << "x)" << (matches() ? "" : " MISMATCH");
+    }
+    ThreadPool pool(4);
+    for (int bucketWidth : {width / 4, width * 4}) {
+        double ms = timeMs(1, [&] {
+            for (int source : sources) search.run(frozen, source, pool, Metric::Distance, bucketWidth);
+        }) / sources.size();
+        std::cout << " | delta " << bucketWidth << " " << ms << " ms" << (matches() ? "" : " MISMATCH");
+    }
+    std::cout << " | default delta " << width << std::endl;
+}
+
+// Compares k shortest loopless routes (k = 10) against single shortest-route queries (bidirectional, and the
+// one-directional Dijkstra whose reverse tree the spur searches share), with the spur searches run sequentially
+// and on a pool
+void benchmarkKShortest(int airportCount) {
+    FrozenGraph frozen = makeSyntheticGraph(airportCount, 8, 67).freeze();
+    std::mt19937 rng(31);
+    std::uniform_int_distribution<int> pick(0, frozen.vertexCount() - 1);
+    std::vector<std::pair<int, int>> pairs(100);
+    for (auto& pair : pairs) pair = {pick(rng), pick(rng)};
+
+    ThreadPool pool;
+    long long singleTotal = 0, sequentialTotal = 0, pooledTotal = 0;
+    double singleMs = timeMs(1, [&] {
+        for (const auto& pair : pairs) singleTotal += frozen.shortestRoute(pair.first, pair.second).distance;
+    });
+    SearchWorkspace& ws = SearchWorkspace::local(0);
+    double dijkstraMs = timeMs(1, [&] {
+        for (const auto& pair : pairs) dijkstra(frozen, pair.second, pair.first, ws, Metric::Distance, Direction::Backward);
+    });
+    double sequentialMs = timeMs(1, [&] {
+        for (const auto& pair : pairs) {
+            std::vector<RouteResult> routes = frozen.kShortestRoutes(pair.first, pair.second, 10);
+            if (!routes.empty()) sequentialTotal += routes.front().distance;
+        }
+    });
+    double pooledMs = timeMs(1, [&] {
+        for (const auto& pair : pairs) {
+            std::vector<RouteResult> routes = frozen.kShortestRoutes(pair.first, pair.second, 10, Metric::Distance, &pool);
+            if (!routes.empty()) pooledTotal += routes.front().distance;
+        }
+    });
+    std::cout << "k-shortest V=" << frozen.vertexCount() << " k=10 | single route " << singleMs * 1000 / pairs.size()
+              << " us, dijkstra " << dijkstraMs * 1000 / pairs.size() << " us | sequential " << sequentialMs * 1000 / pairs.size() << " us | pool(" << pool.size() << ") "
+              << pooledMs * 1000 / pairs.size() << " us"
+              << (singleTotal == sequentialTotal && singleTotal == pooledTotal ? "" : " MISMATCH") << std::endl;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && std::string(argv[1]) == "--suite") {
+        runSuite(argc > 2 ? std::atoi(argv[2]) : 1000000);
+        return 0;
+    }
+    for (int airportCount : {1000, 4000, 16000}) {
+        benchmarkLayouts(airportCount);
+    }
+    for (int airportCount : {1000, 16000}) {
+        benchmarkDijkstra(airportCount);
+    }
+    for (int airportCount : {1000, 16000}) {
+        benchmarkPareto(airportCount);
+    }
+    for (int airportCount : {1000, 16000}) {
+        benchmarkContraction(airportCount);
+    }
+    for (int airportCount : {16000, 256000}) {
+        benchmarkSnapshot(airportCount);
+    }
+    benchmarkLoader(256000);
+    benchmarkBatch(64000);
+    for (int airportCount : {1000, 2000}) {
+        benchmarkAllPairs(airportCount);
+    }
+    for (int airportCount : {4000, 250000, 1000000}) {
+        benchmarkSpanning(airportCount);
+    }
+    for (int airportCount : {16000, 256000}) {
+        benchmarkUndirected(airportCount);
+    }
+    for (int airportCount : {16000, 1000000}) {
+        benchmarkHubs(airportCount);
+    }
+    for (int landmarkCount : {4, 16}) {
+        benchmarkLandmarks(64000, landmarkCount);
+    }
+    for (int airportCount : {16000, 256000}) {
+        benchmarkBidirectional(airportCount);
+    }
+    for (int airportCount : {16000, 256000}) {
+        benchmarkCache(airportCount);
+    }
+    for (int airportCount : {16000, 256000}) {
+        benchmarkStateSearch(airportCount);
+    }
+    for (int airportCount : {16000, 256000}) {
+        benchmarkInstrumentation(airportCount);
+    }
+    for (int airportCount : {16000, 1000000}) {
+        benchmarkMetadata(airportCount);
+    }
+    for (int airportCount : {16000, 256000}) {
+        benchmarkServer(airportCount);
+    }
+    for (int airportCount : {16000, 256000}) {
+        benchmarkKShortest(airportCount);
+    }
+    for (int airportCount : {256, 1024, 2048}) {
+        benchmarkDense(airportCount);
+    }
+    for (int airportCount : {256000, 1000000}) {
+        benchmarkDeltaStepping(airportCount);
+    }
+    return 0;
+}
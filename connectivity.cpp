@@ -0,0 +1,239 @@
+#include "connectivity.h"
+#include <algorithm>
+#include <cstring>
+
+// Union-find helpers
+// Returns the representative of a component's weakly connected group. build() flattens the forest, so
+// this is usually a single step; union by size keeps incremental chains logarithmic
+int ConnectivityIndex::weakRoot(int c) const {
+    while (weakParent[c] != c) c = weakParent[c];
+    return c;
+}
+
+// Merges the weakly connected groups of two components
+void ConnectivityIndex::joinWeak(int a, int b) {
+    a = weakRoot(a);
+    b = weakRoot(b);
+    if (a == b) return;
+    if (weakSize[a] < weakSize[b]) std::swap(a, b);
+    weakParent[b] = a;
+    weakSize[a] += weakSize[b];
+}
+
+// Tests bit `to` of component from's reach set (exact mode only)
+bool ConnectivityIndex::componentReaches(int from, int to) const {
+    const std::vector<uint64_t>& row = reach[from];
+    size_t word = static_cast<size_t>(to) >> 6;
+    return word < row.size() && ((row[word] >> (to & 63)) & 1);
+}
+
+// Index construction
+// Rebuilds the index from CSR adjacency arrays in O(V + E) (plus O(E * C / 64) for exact reach sets).
+// Tarjan's algorithm runs on an explicit stack so long chains of airports can't overflow the call stack
+void ConnectivityIndex::build(int n, const int* offsets, const int* targets) {
+    const int UNVISITED = -1;
+    component.assign(n, UNVISITED);
+    components = 0;
+
+    std::vector<int> order(n, UNVISITED); // Discovery index of each vertex
+    std::vector<int> low(n, 0);
+    std::vector<int> nextEdge(n, 0); // Next outbound edge to explore while the vertex is on the call stack
+    std::vector<int> sccStack;
+    std::vector<int> callStack;
+    int counter = 0;
+
+    for (int root = 0; root < n; ++root) {
+        if (order[root] != UNVISITED) continue;
+        order[root] = low[root] = counter++;
+        nextEdge[root] = offsets[root];
+        sccStack.push_back(root);
+        callStack.push_back(root);
+
+        while (!callStack.empty()) {
+            int u = callStack.back();
+            if (nextEdge[u] < offsets[u + 1]) {
+                int v = targets[nextEdge[u]++];
+                if (order[v] == UNVISITED) { // Tree edge: descend into v
+                    order[v] = low[v] = counter++;
+                    nextEdge[v] = offsets[v];
+                    sccStack.push_back(v);
+                    callStack.push_back(v);
+                } else if (component[v] == UNVISITED) { // v is still on the SCC stack
+                    low[u] = std::min(low[u], order[v]);
+                }
+                continue;
+            }
+
+            // Every edge of u explored; pop it and pass its low link to the parent
+            callStack.pop_back();
+            if (!callStack.empty()) {
+                int parent = callStack.back();
+                low[parent] = std::min(low[parent], low[u]);
+            }
+            if (low[u] == order[u]) { // u is the root of a component
+                int v;
+                do {
+                    v = sccStack.back();
+                    sccStack.pop_back();
+                    component[v] = components;
+                } while (v != u);
+                components++;
+            }
+        }
+    }
+
+    // Weakly connected groups of components, flattened so every lookup is one step
+    weakParent.resize(components);
+    weakSize.assign(components, 1);
+    for (int c = 0; c < components; ++c) weakParent[c] = c;
+    for (int u = 0; u < n; ++u) {
+        for (int e = offsets[u]; e < offsets[u + 1]; ++e) {
+            joinWeak(component[u], component[targets[e]]);
+        }
+    }
+    for (int c = 0; c < components; ++c) weakParent[c] = weakRoot(c);
+
+    // Exact reach sets, filled sinks first: a flight out of component c always lands in a lower id
+    exact = components <= EXACT_LIMIT;
+    reach.clear();
+    if (!exact) return;
+
+    std::vector<int> memberOffsets(components + 1, 0);
+    for (int v = 0; v < n; ++v) memberOffsets[component[v] + 1]++;
+    for (int c = 0; c < components; ++c) memberOffsets[c + 1] += memberOffsets[c];
+    std::vector<int> members(n);
+    std::vector<int> slot(memberOffsets.begin(), memberOffsets.end() - 1);
+    for (int v = 0; v < n; ++v) members[slot[component[v]]++] = v;
+
+    reach.resize(components);
+    for (int c = 0; c < components; ++c) {
+        std::vector<uint64_t>& row = reach[c];
+        row.assign((c >> 6) + 1, 0);
+        row[c >> 6] |= uint64_t(1) << (c & 63);
+        for (int i = memberOffsets[c]; i < memberOffsets[c + 1]; ++i) {
+            int u = members[i];
+            for (int e = offsets[u]; e < offsets[u + 1]; ++e) {
+                int d = component[targets[e]];
+                if (d == c || componentReaches(c, d)) continue;
+                const std::vector<uint64_t>& other = reach[d];
+                for (size_t w = 0; w < other.size(); ++w) row[w] |= other[w];
+            }
+        }
+    }
+}
+
+// Incremental updates
+// Registers a new, isolated airport. Returns false when the index must be rebuilt instead
+bool ConnectivityIndex::addVertex() {
+    int c = components++;
+    component.push_back(c);
+    weakParent.push_back(c);
+    weakSize.push_back(1);
+    if (!exact) return true; // An isolated component keeps the topological order valid
+    if (components > EXACT_LIMIT) return false;
+    reach.emplace_back((c >> 6) + 1, 0);
+    reach.back()[c >> 6] |= uint64_t(1) << (c & 63);
+    return true;
+}
+
+// Records a new flight. Returns false when the flight merges components (or breaks the topological order
+// the inexact index relies on), in which case the index must be rebuilt
+bool ConnectivityIndex::addEdge(int from, int to) {
+    int cu = component[from], cv = component[to];
+    if (cu == cv) return true;
+    if (!exact) {
+        if (cu < cv) return false;
+        joinWeak(cu, cv);
+        return true;
+    }
+    if (componentReaches(cu, cv)) return true; // Already reachable; nothing changes
+    if (componentReaches(cv, cu)) return false; // Closes a cycle between components
+
+    // Everything that reaches cu now also reaches everything cv reaches
+    const std::vector<uint64_t> added = reach[cv];
+    for (int c = 0; c < components; ++c) {
+        if (!componentReaches(c, cu)) continue;
+        std::vector<uint64_t>& row = reach[c];
+        if (row.size() < added.size()) row.resize(added.size(), 0);
+        for (size_t w = 0; w < added.size(); ++w) row[w] |= added[w];
+    }
+    joinWeak(cu, cv);
+    return true;
+}
+
+// Serialization
+// Appends the index to out: counts, component ids, flattened weak groups, then the reach rows (exact mode)
+void ConnectivityIndex::save(std::string& out) const {
+    auto append = [&](const void* data, size_t bytes) { out.append(static_cast<const char*>(data), bytes); };
+    int32_t header[3] = {vertexCount(), components, exact ? 1 : 0};
+    append(header, sizeof(header));
+    append(component.data(), component.size() * sizeof(int));
+    for (int c = 0; c < components; ++c) {
+        int root = weakRoot(c);
+        append(&root, sizeof(int));
+    }
+    append(weakSize.data(), weakSize.size() * sizeof(int));
+    if (!exact) return;
+    uint64_t words = 0;
+    for (int c = 0; c <= components; ++c) {
+        append(&words, sizeof(words)); // Row c spans words [start of c, start of c + 1)
+        if (c < components) words += reach[c].size();
+    }
+    for (const std::vector<uint64_t>& row : reach) append(row.data(), row.size() * sizeof(uint64_t));
+}
+
+// Reads an index written by save for a graph with the given vertex count. Every id is range-checked, so malformed
+// data fails here instead of indexing out of bounds later; it cannot tell whether the index matches the flights
+bool ConnectivityIndex::load(const char* data, size_t size, int n) {
+    const char* end = data + size;
+    auto take = [&](void* to, uint64_t bytes) {
+        if (bytes > static_cast<uint64_t>(end - data)) return false;
+        std::memcpy(to, data, bytes);
+        data += bytes;
+        return true;
+    };
+    int32_t header[3];
+    if (!take(header, sizeof(header)) || header[0] != n || header[1] < 0 || header[1] > n || header[2] < 0 || header[2] > 1) {
+        return false;
+    }
+    int count = header[1];
+    exact = header[2] == 1;
+    components = count;
+    component.resize(n);
+    weakParent.resize(count);
+    weakSize.resize(count);
+    reach.clear();
+    if (!take(component.data(), static_cast<uint64_t>(n) * sizeof(int)) ||
+        !take(weakParent.data(), static_cast<uint64_t>(count) * sizeof(int)) ||
+        !take(weakSize.data(), static_cast<uint64_t>(count) * sizeof(int))) return false;
+    for (int v = 0; v < n; ++v) {
+        if (component[v] < 0 || component[v] >= count) return false;
+    }
+    for (int c = 0; c < count; ++c) { // Groups must be flattened, so weakRoot always stops after one step
+        if (weakParent[c] < 0 || weakParent[c] >= count || weakParent[weakParent[c]] != weakParent[c]) return false;
+    }
+    if (!exact) return data == end;
+
+    std::vector<uint64_t> starts(count + 1);
+    if (!take(starts.data(), starts.size() * sizeof(uint64_t)) || starts[0] != 0) return false;
+    for (int c = 0; c < count; ++c) {
+        if (starts[c + 1] < starts[c] || starts[c + 1] - starts[c] > static_cast<uint64_t>(count / 64 + 1)) return false;
+    }
+    if (starts[count] * sizeof(uint64_t) != static_cast<uint64_t>(end - data)) return false;
+    reach.resize(count);
+    for (int c = 0; c < count; ++c) {
+        reach[c].resize(starts[c + 1] - starts[c]);
+        take(reach[c].data(), reach[c].size() * sizeof(uint64_t));
+    }
+    return true;
+}
+
+// Queries
+// Returns false only if no route from `from` to `to` can exist; true means a route exists (exact mode) or may exist
+bool ConnectivityIndex::mayReach(int from, int to) const {
+    int cu = component[from], cv = component[to];
+    if (cu == cv) return true;
+    if (weakParent[cu] != weakParent[cv] && weakRoot(cu) != weakRoot(cv)) return false;
+    if (exact) return componentReaches(cu, cv);
+    return cu > cv; // Flights only lead to lower component ids
+}
@@ -0,0 +1,44 @@
+#ifndef CONNECTIVITY_H
+#define CONNECTIVITY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Strongly connected components of the flight graph plus a reachability summary of their condensation DAG,
+// so queries between airports that can never reach each other are rejected without searching.
+// Component ids come from Tarjan's algorithm, which finishes sinks first: every flight between two
+// components goes from a higher id to a lower one. With at most EXACT_LIMIT components each component
+// keeps a bitset of the components it reaches and answers are exact; above that the index falls back to
+// the topological order and weakly connected groups, which still rule out most impossible pairs.
+class ConnectivityIndex {
+private:
+    static const int EXACT_LIMIT = 4096;
+
+    std::vector<int> component; // Component id of each vertex
+    int components = 0;
+    std::vector<int> weakParent; // Union-find over component ids, grouping weakly connected components
+    std::vector<int> weakSize;
+    bool exact = false;
+    std::vector<std::vector<uint64_t>> reach; // Bit d of reach[c] is set when component c reaches component d
+
+    int weakRoot(int c) const;
+    void joinWeak(int a, int b);
+    bool componentReaches(int from, int to) const;
+
+public: // See implementation file for details
+    void build(int vertexCount, const int* offsets, const int* targets);
+    bool addVertex();
+    bool addEdge(int from, int to);
+    void save(std::string& out) const;
+    bool load(const char* data, size_t size, int vertexCount);
+
+    int vertexCount() const { return static_cast<int>(component.size()); }
+    int componentCount() const { return components; }
+    int componentOf(int v) const { return component[v]; }
+    bool isExact() const { return exact; }
+    bool mayReach(int from, int to) const;
+};
+
+#endif
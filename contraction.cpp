@@ -0,0 +1,367 @@
+#include "contraction.h"
+#include "frozengraph.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <queue>
+#include <utility>
+
+namespace {
+
+const int INF = std::numeric_limits<int>::max();
+// Witness searches give up after settling this many vertices and add the shortcut; the cheaper limit is used
+// when only estimating a vertex's priority
+const int WITNESS_SETTLE_LIMIT = 500;
+const int ESTIMATE_SETTLE_LIMIT = 40;
+const char MAGIC[4] = {'A', 'P', 'C', 'H'};
+const uint32_t FORMAT_VERSION = 1;
+
+// Writes a vector of ints as a length followed by the raw values
+void writeInts(std::ostream& out, const std::vector<int>& values) {
+    uint64_t size = values.size();
+    out.write(reinterpret_cast<const char*>(&size), sizeof(size));
+    out.write(reinterpret_cast<const char*>(values.data()), static_cast<std::streamsize>(size * sizeof(int)));
+}
+
+// Reads a vector written by writeInts holding at most maxSize values. It is read in blocks, so a corrupt length
+// runs out of stream after at most one block too many instead of allocating the whole claimed size up front
+bool readInts(std::istream& in, std::vector<int>& values, uint64_t maxSize) {
+    const uint64_t BLOCK = 1 << 16;
+    uint64_t size = 0;
+    if (!in.read(reinterpret_cast<char*>(&size), sizeof(size)) || size > maxSize) return false;
+    values.clear();
+    for (uint64_t done = 0; done < size;) {
+        uint64_t count = std::min(BLOCK, size - done);
+        values.resize(done + count);
+        if (!in.read(reinterpret_cast<char*>(values.data() + done), static_cast<std::streamsize>(count * sizeof(int)))) return false;
+        done += count;
+    }
+    return true;
+}
+
+} // namespace
+
+// Builds the hierarchy for the given graph, minimizing the given metric
+void ContractionHierarchy::build(const FrozenGraph& g, Metric m) {
+    metric = m;
+    int n = g.vertexCount();
+    std::vector<std::vector<Arc>> out(n), in(n); // Remaining arcs; in[w] holds u -> w with to == u
+
+    // Keep only the best flight between each ordered pair of airports
+    for (int u = 0; u < n; ++u) {
+        std::vector<Arc> arcs;
+        for (int e = g.edgeBegin(u); e < g.edgeEnd(u); ++e) {
+            if (g.edgeTarget(e) != u) arcs.push_back({g.edgeTarget(e), g.edgeDistance(e), g.edgeCost(e), -1});
+        }
+        std::sort(arcs.begin(), arcs.end(), [&](const Arc& a, const Arc& b) {
+            return a.to != b.to ? a.to < b.to : weight(a.distance, a.cost) < weight(b.distance, b.cost);
+        });
+        for (size_t i = 0; i < arcs.size(); ++i) {
+            if (i > 0 && arcs[i].to == arcs[i - 1].to) continue;
+            out[u].push_back(arcs[i]);
+            in[arcs[i].to].push_back({u, arcs[i].distance, arcs[i].cost, -1});
+        }
+    }
+
+    std::vector<bool> contracted(n, false);
+    std::vector<int> contractedNeighbors(n, 0);
+
+    // Adds or shortens the arc u -> w
+    auto addArc = [&](int u, int w, int distance, int cost, int middle) {
+        for (auto& arc : out[u]) {
+            if (arc.to != w) continue;
+            if (weight(arc.distance, arc.cost) <= weight(distance, cost)) return;
+            arc = {w, distance, cost, middle};
+            for (auto& back : in[w]) {
+                if (back.to == u) back = {u, distance, cost, middle};
+            }
+            return;
+        }
+        out[u].push_back({w, distance, cost, middle});
+        in[w].push_back({u, distance, cost, middle});
+    };
+
+    // Witness search state: bounded Dijkstra over the remaining graph that skips the vertex being contracted
+    std::vector<int> witness(n, INF);
+    std::vector<int> touched;
+    typedef std::pair<int, int> Entry;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+    auto witnessSearch = [&](int source, int skip, int limit, int settleLimit) {
+        for (int v : touched) witness[v] = INF;
+        touched.clear();
+        queue = {};
+        witness[source] = 0;
+        touched.push_back(source);
+        queue.push({0, source});
+        int settledCount = 0;
+        while (!queue.empty()) {
+            Entry top = queue.top();
+            queue.pop();
+            if (top.first > witness[top.second]) continue;
+            if (top.first > limit || ++settledCount > settleLimit) break;
+            for (const auto& arc : out[top.second]) {
+                if (contracted[arc.to] || arc.to == skip) continue;
+                int alt = top.first + weight(arc.distance, arc.cost);
+                if (alt < witness[arc.to]) {
+                    if (witness[arc.to] == INF) touched.push_back(arc.to);
+                    witness[arc.to] = alt;
+                    queue.push({alt, arc.to});
+                }
+            }
+        }
+    };
+
+    // Counts (or adds, when apply is set) the shortcuts needed to contract v
+    auto contract = [&](int v, bool apply) {
+        int shortcuts = 0;
+        for (const auto& inArc : in[v]) {
+            int u = inArc.to;
+            if (contracted[u]) continue;
+            int limit = -1;
+            for (const auto& outArc : out[v]) {
+                if (!contracted[outArc.to] && outArc.to != u) {
+                    limit = std::max(limit, weight(inArc.distance, inArc.cost) + weight(outArc.distance, outArc.cost));
+                }
+            }
+            if (limit < 0) continue; // No live outbound neighbor besides u
+            witnessSearch(u, v, limit, apply ? WITNESS_SETTLE_LIMIT : ESTIMATE_SETTLE_LIMIT);
+            for (const auto& outArc : out[v]) {
+                int w = outArc.to;
+                if (contracted[w] || w == u) continue;
+                int via = weight(inArc.distance, inArc.cost) + weight(outArc.distance, outArc.cost);
+                if (witness[w] <= via) continue; // Another route is at least as good
+                shortcuts++;
+                if (apply) addArc(u, w, inArc.distance + outArc.distance, inArc.cost + outArc.cost, v);
+            }
+        }
+        return shortcuts;
+    };
+
+    // Priority: edge difference plus already-contracted neighbors, so contraction spreads evenly
+    auto priority = [&](int v) {
+        int degree = 0;
+        for (const auto& arc : in[v]) degree += !contracted[arc.to];
+        for (const auto& arc : out[v]) degree += !contracted[arc.to];
+        return contract(v, false) - degree + contractedNeighbors[v];
+    };
+
+    typedef std::pair<int, int> Candidate;
+    std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate>> order;
+    for (int v = 0; v < n; ++v) order.push({priority(v), v});
+
+    std::vector<std::vector<Arc>> upward(n), downward(n);
+    rank.assign(n, 0);
+    int next = 0;
+    while (!order.empty()) {
+        Candidate top = order.top();
+        order.pop();
+        int v = top.second;
+        if (contracted[v]) continue;
+
+        // Lazy update: re-evaluate and put back if another vertex is now cheaper
+        int current = priority(v);
+        if (!order.empty() && current > order.top().first) {
+            order.push({current, v});
+            continue;
+        }
+
+        contract(v, true);
+        for (const auto& arc : out[v]) {
+            if (contracted[arc.to]) continue;
+            upward[v].push_back(arc);
+            contractedNeighbors[arc.to]++;
+        }
+        for (const auto& arc : in[v]) {
+            if (contracted[arc.to]) continue;
+            downward[v].push_back(arc);
+            contractedNeighbors[arc.to]++;
+        }
+        contracted[v] = true;
+        rank[v] = next++;
+        out[v].clear();
+        out[v].shrink_to_fit();
+        in[v].clear();
+        in[v].shrink_to_fit();
+    }
+
+    // Flatten into CSR arrays
+    upOffsets.assign(1, 0);
+    downOffsets.assign(1, 0);
+    upTargets.clear(); upDistances.clear(); upCosts.clear(); upMiddles.clear();
+    downSources.clear(); downDistances.clear(); downCosts.clear(); downMiddles.clear();
+    for (int v = 0; v < n; ++v) {
+        for (const auto& arc : upward[v]) {
+            upTargets.push_back(arc.to);
+            upDistances.push_back(arc.distance);
+            upCosts.push_back(arc.cost);
+            upMiddles.push_back(arc.middle);
+        }
+        upOffsets.push_back(static_cast<int>(upTargets.size()));
+        for (const auto& arc : downward[v]) {
+            downSources.push_back(arc.to);
+            downDistances.push_back(arc.distance);
+            downCosts.push_back(arc.cost);
+            downMiddles.push_back(arc.middle);
+        }
+        downOffsets.push_back(static_cast<int>(downSources.size()));
+    }
+}
+
+// Returns the middle vertex of the hierarchy arc from -> to (-1 for a real flight)
+int ContractionHierarchy::findMiddle(int from, int to) const {
+    if (rank[from] < rank[to]) {
+        for (int e = upOffsets[from]; e < upOffsets[from + 1]; ++e) {
+            if (upTargets[e] == to) return upMiddles[e];
+        }
+    } else {
+        for (int e = downOffsets[to]; e < downOffsets[to + 1]; ++e) {
+            if (downSources[e] == from) return downMiddles[e];
+        }
+    }
+    return -1;
+}
+
+// Appends the real vertices after from on the arc from -> to, expanding shortcuts on an explicit stack (a long
+// chain of nested shortcuts can't overflow the call stack)
+void ContractionHierarchy::unpack(int from, int to, std::vector<int>& path) const {
+    std::vector<std::pair<int, int>> pending{{from, to}}; // Arcs still to expand, last one first
+    while (!pending.empty()) {
+        std::pair<int, int> arc = pending.back();
+        pending.pop_back();
+        int middle = findMiddle(arc.first, arc.second);
+        if (middle == -1) {
+            path.push_back(arc.second);
+            continue;
+        }
+        pending.push_back({middle, arc.second});
+        pending.push_back({arc.first, middle});
+    }
+}
+
+// Shortest route between two vertex indices: bidirectional upward search, then shortcut unpacking
+RouteResult ContractionHierarchy::route(int origin, int destination) const {
+    RouteResult result;
+    int n = vertexCount();
+    SearchWorkspace& forward = SearchWorkspace::local(0);
+    SearchWorkspace& backward = SearchWorkspace::local(1);
+    forward.begin(n);
+    backward.begin(n);
+    forward.improve(origin, 0, 0, 0, -1);
+    backward.improve(destination, 0, 0, 0, -1);
+
+    int best = INF;
+    int meet = -1;
+    while (true) {
+        int forwardMin = forward.empty() ? INF : forward.minKey();
+        int backwardMin = backward.empty() ? INF : backward.minKey();
+        if (std::min(forwardMin, backwardMin) >= best) break; // Covers both queues running dry
+
+        bool isForward = forwardMin <= backwardMin;
+        SearchWorkspace& side = isForward ? forward : backward;
+        const SearchWorkspace& other = isForward ? backward : forward;
+        int u = side.popMin();
+        if (other.reached(u) && side.key(u) + other.key(u) < best) {
+            best = side.key(u) + other.key(u);
+            meet = u;
+        }
+
+        int key = side.key(u), distance = side.distance(u), cost = side.cost(u);
+        if (isForward) {
+            for (int e = upOffsets[u]; e < upOffsets[u + 1]; ++e) {
+                side.improve(upTargets[e], key + weight(upDistances[e], upCosts[e]), distance + upDistances[e], cost + upCosts[e], u);
+            }
+        } else {
+            for (int e = downOffsets[u]; e < downOffsets[u + 1]; ++e) {
+                side.improve(downSources[e], key + weight(downDistances[e], downCosts[e]), distance + downDistances[e], cost + downCosts[e], u);
+            }
+        }
+    }
+    if (meet == -1) return result;
+
+    // Hierarchy vertices origin .. meet .. destination, then expand each arc
+    std::vector<int> hierarchyPath;
+    for (int at = meet; at != -1; at = forward.parent(at)) hierarchyPath.push_back(at);
+    std::reverse(hierarchyPath.begin(), hierarchyPath.end());
+    for (int at = backward.parent(meet); at != -1; at = backward.parent(at)) hierarchyPath.push_back(at);
+
+    result.found = true;
+    result.path.push_back(origin);
+    for (size_t i = 0; i + 1 < hierarchyPath.size(); ++i) {
+        unpack(hierarchyPath[i], hierarchyPath[i + 1], result.path);
+    }
+    result.distance = forward.distance(meet) + backward.distance(meet);
+    result.cost = forward.cost(meet) + backward.cost(meet);
+    return result;
+}
+
+// Writes the hierarchy in a versioned binary format. Returns whether the stream accepted it
+bool ContractionHierarchy::save(std::ostream& out) const {
+    uint32_t version = FORMAT_VERSION;
+    uint32_t metricId = static_cast<uint32_t>(metric);
+    out.write(MAGIC, sizeof(MAGIC));
+    out.write(reinterpret_cast<const char*>(&version), sizeof(version));
+    out.write(reinterpret_cast<const char*>(&metricId), sizeof(metricId));
+    for (const auto* values : {&rank, &upOffsets, &upTargets, &upDistances, &upCosts, &upMiddles,
+                               &downOffsets, &downSources, &downDistances, &downCosts, &downMiddles}) {
+        writeInts(out, *values);
+    }
+    return static_cast<bool>(out);
+}
+
+// Reads a hierarchy written by save. Fails (leaving this object unusable) if the data is malformed or built for another graph
+bool ContractionHierarchy::load(std::istream& in, const FrozenGraph& g) {
+    char magic[sizeof(MAGIC)];
+    uint32_t version = 0;
+    uint32_t metricId = 0;
+    if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0) return false;
+    if (!in.read(reinterpret_cast<char*>(&version), sizeof(version)) || version != FORMAT_VERSION) return false;
+    if (!in.read(reinterpret_cast<char*>(&metricId), sizeof(metricId)) || metricId > 1) return false;
+    metric = static_cast<Metric>(metricId);
+    int n = g.vertexCount();
+    uint64_t arcLimit = std::numeric_limits<int>::max(); // Offsets are ints
+    for (auto* values : {&rank, &upOffsets, &upTargets, &upDistances, &upCosts, &upMiddles,
+                         &downOffsets, &downSources, &downDistances, &downCosts, &downMiddles}) {
+        uint64_t limit = (values == &rank) ? n : (values == &upOffsets || values == &downOffsets) ? n + 1 : arcLimit;
+        if (!readInts(in, *values, limit)) return false;
+    }
+
+    // Structural sanity checks so a bad file can't index out of bounds
+    if (static_cast<int>(rank.size()) != n || upOffsets.size() != n + 1 || downOffsets.size() != n + 1) return false;
+    if (upOffsets[0] != 0 || downOffsets[0] != 0) return false;
+    if (upOffsets.back() != static_cast<int>(upTargets.size()) || downOffsets.back() != static_cast<int>(downSources.size())) return false;
+    if (upDistances.size() != upTargets.size() || upCosts.size() != upTargets.size() || upMiddles.size() != upTargets.size()) return false;
+    if (downDistances.size() != downSources.size() || downCosts.size() != downSources.size() || downMiddles.size() != downSources.size()) return false;
+    for (int v = 0; v < n; ++v) {
+        if (upOffsets[v] > upOffsets[v + 1] || downOffsets[v] > downOffsets[v + 1]) return false;
+    }
+    for (const auto* ids : {&rank, &upTargets, &downSources}) {
+        for (int id : *ids) if (id < 0 || id >= n) return false;
+    }
+    for (const auto* ids : {&upMiddles, &downMiddles}) {
+        for (int id : *ids) if (id < -1 || id >= n) return false;
+    }
+
+    // Hierarchy invariants the searches and unpack rely on: rank is a permutation, up arcs climb, down arcs
+    // descend into their vertex, and every shortcut bypasses a vertex ranked below both of its ends, so
+    // unpacking always reaches real flights
+    std::vector<bool> used(n, false);
+    for (int r : rank) {
+        if (used[r]) return false;
+        used[r] = true;
+    }
+    for (int u = 0; u < n; ++u) {
+        for (int e = upOffsets[u]; e < upOffsets[u + 1]; ++e) {
+            int w = upTargets[e], middle = upMiddles[e];
+            if (rank[w] <= rank[u] || (middle != -1 && rank[middle] >= rank[u])) return false;
+        }
+        for (int e = downOffsets[u]; e < downOffsets[u + 1]; ++e) {
+            int w = downSources[e], middle = downMiddles[e];
+            if (rank[w] <= rank[u] || (middle != -1 && rank[middle] >= rank[u])) return false;
+        }
+    }
+    return true;
+}
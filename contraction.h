@@ -0,0 +1,56 @@
+#ifndef CONTRACTION_H
+#define CONTRACTION_H
+
+#include <iosfwd>
+#include <vector>
+#include "routing.h"
+
+class FrozenGraph;
+
+// Contraction hierarchy over a frozen graph for fast repeated point-to-point queries.
+// Vertices are contracted one at a time (fewest added shortcuts first); every shortcut records the
+// distance and cost of the two arcs it replaces plus the contracted middle vertex, so query results
+// unpack back into real flights with their real cost. Queries run a bidirectional search that only
+// climbs to higher-ranked vertices.
+class ContractionHierarchy {
+private:
+    struct Arc { // Arc used while building
+        int to;
+        int distance;
+        int cost;
+        int middle; // Contracted vertex this shortcut bypasses, -1 for a real flight
+    };
+
+    Metric metric = Metric::Distance;
+    std::vector<int> rank; // Contraction order of each vertex
+
+    // Upward arcs u -> w with rank[w] > rank[u], stored at u
+    std::vector<int> upOffsets{0};
+    std::vector<int> upTargets;
+    std::vector<int> upDistances;
+    std::vector<int> upCosts;
+    std::vector<int> upMiddles;
+
+    // Downward arcs u -> w with rank[u] > rank[w], stored reversed at w (downSources hold u)
+    std::vector<int> downOffsets{0};
+    std::vector<int> downSources;
+    std::vector<int> downDistances;
+    std::vector<int> downCosts;
+    std::vector<int> downMiddles;
+
+    int weight(int distance, int cost) const { return (metric == Metric::Distance) ? distance : cost; }
+    int findMiddle(int from, int to) const;
+    void unpack(int from, int to, std::vector<int>& path) const;
+
+public: // See implementation file for details
+    void build(const FrozenGraph& g, Metric metric = Metric::Distance);
+    bool save(std::ostream& out) const;
+    bool load(std::istream& in, const FrozenGraph& g);
+
+    int vertexCount() const { return static_cast<int>(rank.size()); }
+    int arcCount() const { return static_cast<int>(upTargets.size() + downSources.size()); }
+    Metric getMetric() const { return metric; }
+    RouteResult route(int origin, int destination) const;
+};
+
+#endif
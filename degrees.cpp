@@ -0,0 +1,108 @@
+#include "degrees.h"
+#include <algorithm>
+
+// Ranking maintenance
+// Moves v from its degree d block to the end of the d + 1 block (which sits just before it): swap v with the
+// first airport of its block and shrink that block by one from the front
+void DegreeIndex::raise(int v) {
+    int d = degree(v);
+    if (blockStart.size() < d + 2) {
+        blockStart.resize(d + 2, 0);
+        blockSize.resize(d + 2, 0);
+    }
+    int first = blockStart[d];
+    int displaced = ranked[first];
+    std::swap(ranked[first], ranked[position[v]]);
+    position[displaced] = position[v];
+    position[v] = first;
+
+    blockStart[d]++;
+    blockSize[d]--;
+    if (blockSize[d + 1] == 0) blockStart[d + 1] = first;
+    blockSize[d + 1]++;
+}
+
+// Moves v from its degree d block to the front of the d - 1 block (which sits just after it)
+void DegreeIndex::lower(int v) {
+    int d = degree(v);
+    int last = blockStart[d] + blockSize[d] - 1;
+    int displaced = ranked[last];
+    std::swap(ranked[last], ranked[position[v]]);
+    position[displaced] = position[v];
+    position[v] = last;
+
+    blockSize[d]--;
+    blockStart[d - 1] = last;
+    blockSize[d - 1]++;
+}
+
+// Index construction
+// Rebuilds the counters and ranking from per-airport counts with a counting sort, O(V + max degree)
+void DegreeIndex::build(const std::vector<int>& inboundCounts, const std::vector<int>& outboundCounts) {
+    inbound = inboundCounts;
+    outbound = outboundCounts;
+    int n = static_cast<int>(inbound.size());
+    int maxDegree = 0;
+    for (int v = 0; v < n; ++v) maxDegree = std::max(maxDegree, degree(v));
+
+    blockSize.assign(maxDegree + 2, 0);
+    blockStart.assign(maxDegree + 2, 0);
+    for (int v = 0; v < n; ++v) blockSize[degree(v)]++;
+    int next = 0;
+    for (int d = maxDegree; d >= 0; --d) {
+        blockStart[d] = next;
+        next += blockSize[d];
+    }
+
+    ranked.resize(n);
+    position.resize(n);
+    std::vector<int> fill(blockStart);
+    for (int v = 0; v < n; ++v) {
+        position[v] = fill[degree(v)]++;
+        ranked[position[v]] = v;
+    }
+}
+
+// Incremental updates
+// Registers a new airport with no flights; it joins the degree 0 block at the end of the ranking
+void DegreeIndex::addVertex() {
+    int v = static_cast<int>(ranked.size());
+    inbound.push_back(0);
+    outbound.push_back(0);
+    ranked.push_back(v);
+    position.push_back(v);
+    if (blockSize.empty()) {
+        blockStart.assign(2, 0);
+        blockSize.assign(2, 0);
+    }
+    if (blockSize[0] == 0) blockStart[0] = v;
+    blockSize[0]++;
+}
+
+// Counts a new flight from -> to in O(1)
+void DegreeIndex::addEdge(int from, int to) {
+    raise(from);
+    outbound[from]++;
+    raise(to);
+    inbound[to]++;
+}
+
+// Uncounts a removed flight from -> to in O(1)
+void DegreeIndex::removeEdge(int from, int to) {
+    lower(from);
+    outbound[from]--;
+    lower(to);
+    inbound[to]--;
+}
+
+// Queries
+// Returns the k airports with the most flights (in + out), busiest first and ties by airport index.
+// Airports tied at the cut-off are included in whatever order the ranking holds them. O(k log k)
+std::vector<int> DegreeIndex::top(size_t k) const {
+    k = std::min(k, ranked.size());
+    std::vector<int> hubs(ranked.begin(), ranked.begin() + k);
+    std::sort(hubs.begin(), hubs.end(), [this](int a, int b) {
+        return degree(a) > degree(b) || (degree(a) == degree(b) && a < b);
+    });
+    return hubs;
+}
@@ -0,0 +1,36 @@
+#ifndef DEGREES_H
+#define DEGREES_H
+
+#include <cstddef>
+#include <vector>
+
+// Inbound/outbound flight counters per airport plus a ranking of airports by total degree, updated in O(1)
+// per added or removed flight. The ranking is a bucketed degree histogram laid out in one array: airports
+// sorted by descending degree, with the start of each degree's block recorded, so moving an airport to the
+// next degree is a single swap with the edge of its block and the k busiest hubs are the array's first k entries.
+class DegreeIndex {
+private:
+    std::vector<int> inbound;
+    std::vector<int> outbound;
+    std::vector<int> ranked; // Airports by descending total degree
+    std::vector<int> position; // Index of each airport in ranked
+    std::vector<int> blockStart; // Index in ranked of the first airport with each total degree
+    std::vector<int> blockSize;
+
+    void raise(int v);
+    void lower(int v);
+
+public: // See implementation file for details
+    void build(const std::vector<int>& inboundCounts, const std::vector<int>& outboundCounts);
+    void addVertex();
+    void addEdge(int from, int to);
+    void removeEdge(int from, int to);
+
+    int vertexCount() const { return static_cast<int>(ranked.size()); }
+    int inDegree(int v) const { return inbound[v]; }
+    int outDegree(int v) const { return outbound[v]; }
+    int degree(int v) const { return inbound[v] + outbound[v]; }
+    std::vector<int> top(size_t k) const;
+};
+
+#endif
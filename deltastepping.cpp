@@ -0,0 +1,154 @@
+#include "deltastepping.h"
+#include "frozengraph.h"
+#include "threadpool.h"
+#include <algorithm>
+
+// Returns the bucket width the search uses unless told otherwise: the heaviest flight divided by the average
+// number of flights per airport, the width Meyer and Sanders suggest for random weights. Light rounds then
+// re-relax few vertices while the buckets stay wide enough to give every thread work
+int DeltaStepping::defaultDelta(const FrozenGraph& g, Metric metric) {
+    int heaviest = 1;
+    for (int e = 0; e < g.edgeCount(); ++e) {
+        heaviest = std::max(heaviest, (metric == Metric::Distance) ? g.edgeDistance(e) : g.edgeCost(e));
+    }
+    int degree = std::max(1, g.edgeCount() / std::max(1, g.vertexCount()));
+    return std::max(1, heaviest / degree);
+}
+
+// Lowers v's key to key with the given parent if that is strictly smaller. Returns whether it did
+bool DeltaStepping::lower(int v, uint32_t key, int parent) {
+    uint64_t label = labels[v].load(std::memory_order_relaxed);
+    uint64_t wanted = (static_cast<uint64_t>(key) << 32) | static_cast<uint32_t>(parent);
+    while (key < (label >> 32)) {
+        if (labels[v].compare_exchange_weak(label, wanted, std::memory_order_relaxed)) return true;
+    }
+    return false;
+}
+
+// Relaxes the light (or heavy) flights of the given vertices in parallel, CHUNK vertices per task. Every vertex a
+// task lowers goes into that task's improved list
+template <bool Light>
+void DeltaStepping::relaxFrontier(const FrozenGraph& g, const std::vector<int>& vertices, ThreadPool& pool) {
+    size_t chunks = (vertices.size() + CHUNK - 1) / CHUNK;
+    if (improved.size() < chunks) improved.resize(chunks);
+    auto relaxChunk = [&](size_t chunk) {
+        std::vector<int>& out = improved[chunk];
+        size_t end = std::min(vertices.size(), (chunk + 1) * CHUNK);
+        for (size_t i = chunk * CHUNK; i < end; ++i) {
+            int u = vertices[i];
+            uint32_t key = static_cast<uint32_t>(labels[u].load(std::memory_order_relaxed) >> 32);
+            for (int e = g.edgeBegin(u); e < g.edgeEnd(u); ++e) {
+                int weight = (metric == Metric::Distance) ? g.edgeDistance(e) : g.edgeCost(e);
+                if ((weight <= delta) != Light) continue;
+                int v = g.edgeTarget(e);
+                if (lower(v, key + weight, u)) out.push_back(v);
+            }
+        }
+    };
+    if (chunks == 1) {
+        relaxChunk(0); // Not worth waking the pool
+    } else if (chunks > 1) {
+        pool.parallelFor(chunks, relaxChunk);
+    }
+}
+
+// Moves every vertex the last relaxation lowered into the bucket of its current key. A vertex lowered twice is
+// queued twice; the copy that no longer matches its bucket is dropped when that bucket is reached
+void DeltaStepping::queueImproved() {
+    for (std::vector<int>& list : improved) {
+        for (int v : list) {
+            size_t bucket = static_cast<size_t>(labels[v].load(std::memory_order_relaxed) >> 32) / delta;
+            if (bucket >= buckets.size()) buckets.resize(bucket + 1);
+            buckets[bucket].push_back(v);
+        }
+        list.clear();
+    }
+}
+
+// Runs the search from source on the pool's threads (the pool size is the thread count). A bucketWidth of 0
+// picks defaultDelta. Afterwards key, parent and extractRoute read the result
+void DeltaStepping::run(const FrozenGraph& g, int source, ThreadPool& pool, Metric m, int bucketWidth) {
+    n = g.vertexCount();
+    metric = m;
+    delta = (bucketWidth > 0) ? bucketWidth : defaultDelta(g, metric);
+    if (capacity < n) {
+        labels.reset(new std::atomic<uint64_t>[n]);
+        capacity = n;
+        frontierStamp.assign(n, 0);
+        bucketStamp.assign(n, 0);
+        round = bucketRound = 0;
+    }
+    const size_t FILL = 1 << 16;
+    pool.parallelFor((n + FILL - 1) / FILL, [&](size_t block) {
+        size_t end = std::min(static_cast<size_t>(n), (block + 1) * FILL);
+        for (size_t v = block * FILL; v < end; ++v) labels[v].store(UNREACHED, std::memory_order_relaxed);
+    });
+    for (std::vector<int>& bucket : buckets) bucket.clear();
+    if (source < 0 || source >= n) return;
+
+    lower(source, 0, -1);
+    if (buckets.empty()) buckets.resize(1);
+    buckets[0].push_back(source);
+
+    for (size_t b = 0; b < buckets.size(); ++b) {
+        if (buckets[b].empty()) continue;
+        if (++bucketRound == 0) { // Stamp counter wrapped; old stamps could look current again
+            std::fill(bucketStamp.begin(), bucketStamp.end(), 0);
+            bucketRound = 1;
+        }
+        settledInBucket.clear();
+
+        // Light rounds: relaxing a light flight can lower a key into this same bucket, so repeat until it stays empty
+        while (!buckets[b].empty()) {
+            if (++round == 0) {
+                std::fill(frontierStamp.begin(), frontierStamp.end(), 0);
+                round = 1;
+            }
+            frontier.clear();
+            for (int v : buckets[b]) {
+                size_t current = static_cast<size_t>(labels[v].load(std::memory_order_relaxed) >> 32) / delta;
+                if (current != b || frontierStamp[v] == round) continue;
+                frontierStamp[v] = round;
+                frontier.push_back(v);
+                if (bucketStamp[v] != bucketRound) {
+                    bucketStamp[v] = bucketRound;
+                    settledInBucket.push_back(v);
+                }
+            }
+            buckets[b].clear();
+            relaxFrontier<true>(g, frontier, pool);
+            queueImproved();
+        }
+
+        // Heavy flights leave the bucket, so one pass over everything it settled is enough
+        relaxFrontier<false>(g, settledInBucket, pool);
+        queueImproved();
+    }
+}
+
+// Reads the route to destination off the predecessor tree. Each hop takes the first flight whose weight matches
+// the key difference, as Dijkstra would. Returns false if destination was not reached
+bool DeltaStepping::extractRoute(const FrozenGraph& g, int destination, RouteResult& result) const {
+    result.path.clear();
+    result.found = destination >= 0 && destination < n && reached(destination);
+    if (!result.found) return false;
+
+    int hops = 0;
+    for (int at = destination; at != -1; at = parent(at)) ++hops;
+    result.path.resize(hops);
+    for (int at = destination; at != -1; at = parent(at)) result.path[--hops] = at;
+
+    result.distance = 0;
+    result.cost = 0;
+    for (size_t i = 1; i < result.path.size(); ++i) {
+        int from = result.path[i - 1], to = result.path[i];
+        int weight = key(to) - key(from);
+        for (int e = g.edgeBegin(from); e < g.edgeEnd(from); ++e) {
+            if (g.edgeTarget(e) != to || ((metric == Metric::Distance) ? g.edgeDistance(e) : g.edgeCost(e)) != weight) continue;
+            result.distance += g.edgeDistance(e);
+            result.cost += g.edgeCost(e);
+            break;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,57 @@
+#ifndef DELTASTEPPING_H
+#define DELTASTEPPING_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "routing.h"
+
+class FrozenGraph;
+class ThreadPool;
+
+// Parallel single-source search (delta-stepping) for whole-graph searches on very large networks. Tentative keys
+// are grouped into buckets of width delta; the lowest bucket is emptied by repeatedly relaxing the light flights
+// (weight <= delta) of everything in it in parallel, then the heavy flights of everything it settled are relaxed
+// once. Each label is one 64-bit word (key << 32 | parent) lowered with a compare-and-swap that only takes a
+// strictly smaller key, so the keys equal Dijkstra's and every parent had its final key before it was recorded,
+// which keeps the predecessor tree acyclic even across zero-weight flights. Ties may pick other parents than
+// Dijkstra, depending on thread timing.
+class DeltaStepping {
+private:
+    static constexpr uint64_t UNREACHED = UINT64_MAX;
+    static constexpr int CHUNK = 256; // Frontier vertices per parallel task
+
+    int n = 0;
+    int delta = 1;
+    Metric metric = Metric::Distance;
+    std::unique_ptr<std::atomic<uint64_t>[]> labels;
+    int capacity = 0;
+
+    std::vector<std::vector<int>> buckets;  // Vertices whose key fell in [b * delta, (b + 1) * delta) when queued
+    std::vector<int> frontier;              // The bucket being relaxed, without stale or repeated entries
+    std::vector<int> settledInBucket;       // Everything the current bucket settled, for the heavy phase
+    std::vector<std::vector<int>> improved; // Vertices each task lowered, merged into buckets serially
+    std::vector<uint32_t> frontierStamp;    // Marks vertices already in the frontier (per light round)
+    std::vector<uint32_t> bucketStamp;      // Marks vertices already in settledInBucket (per bucket)
+    uint32_t round = 0;
+    uint32_t bucketRound = 0;
+
+    bool lower(int v, uint32_t key, int parent);
+    template <bool Light>
+    void relaxFrontier(const FrozenGraph& g, const std::vector<int>& vertices, ThreadPool& pool);
+    void queueImproved();
+
+public: // See implementation file for details
+    static int defaultDelta(const FrozenGraph& g, Metric metric);
+
+    void run(const FrozenGraph& g, int source, ThreadPool& pool, Metric metric = Metric::Distance, int bucketWidth = 0);
+
+    int bucketWidth() const { return delta; }
+    bool reached(int v) const { return labels[v].load(std::memory_order_relaxed) != UNREACHED; }
+    int key(int v) const { return static_cast<int>(labels[v].load(std::memory_order_relaxed) >> 32); }
+    int parent(int v) const { return static_cast<int32_t>(labels[v].load(std::memory_order_relaxed) & 0xFFFFFFFFu); }
+    bool extractRoute(const FrozenGraph& g, int destination, RouteResult& result) const;
+};
+
+#endif
@@ -0,0 +1,420 @@
+#include "dense.h"
+#include "frozengraph.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define DENSE_X86 1
+#endif
+
+// Largest graph the dense engines run on; a directed matrix takes 8 bytes per cell per metric
+static const int DENSE_MAX_VERTICES = 2048;
+
+// AlignedInts methods
+// Frees the buffer
+AlignedInts::~AlignedInts() {
+    std::free(values);
+}
+
+// Resizes the buffer to size values, reallocating only when the size changes. The values are left unspecified
+void AlignedInts::resize(size_t size) {
+    if (size == count) return;
+    std::free(values);
+    values = nullptr;
+    count = size;
+    if (size > 0) {
+        size_t bytes = (size * sizeof(int32_t) + 63) / 64 * 64; // aligned_alloc wants a multiple of the alignment
+        values = static_cast<int32_t*>(std::aligned_alloc(64, bytes));
+    }
+}
+
+// Resizes the buffer to size values and fills it with value
+void AlignedInts::assign(size_t size, int32_t value) {
+    resize(size);
+    std::fill(values, values + size, value);
+}
+
+// Kernels
+namespace {
+
+// One row relaxation: keys[i] = min(keys[i], key + weights[i]), recording parent (and the secondary total) where it
+// improves. key + weights[i] is computed as key + min(weights[i], UNREACHED - key) so a missing flight lands on
+// UNREACHED and never overflows. Settled vertices hold SETTLED, which no candidate is below. The kernels return
+// the smallest key left afterwards, compared as unsigned so SETTLED counts as the largest
+struct RelaxArgs {
+    int32_t* keys;
+    int32_t* parents;
+    int32_t* secondaries;
+    const int32_t* weights;
+    const int32_t* secondaryWeights;
+    int32_t key;
+    int32_t secondary;
+    int32_t parent;
+    int count; // A multiple of 8
+};
+
+struct Kernels {
+    uint32_t (*relax)(const RelaxArgs& a);     // Also updates secondaries
+    uint32_t (*relaxKeys)(const RelaxArgs& a); // Keys and parents only (Prim)
+    int (*find)(const int32_t* keys, uint32_t value, int count);
+};
+
+template <bool Secondary>
+uint32_t relaxScalar(const RelaxArgs& a) {
+    uint32_t best = UINT32_MAX;
+    int32_t room = DenseWorkspace::UNREACHED - a.key;
+    for (int i = 0; i < a.count; ++i) {
+        int32_t candidate = a.key + std::min(a.weights[i], room);
+        if (candidate < a.keys[i]) {
+            a.keys[i] = candidate;
+            a.parents[i] = a.parent;
+            if (Secondary) a.secondaries[i] = a.secondary + a.secondaryWeights[i];
+        }
+        best = std::min(best, static_cast<uint32_t>(a.keys[i]));
+    }
+    return best;
+}
+
+// Returns the first index whose key equals value, or -1
+int findScalar(const int32_t* keys, uint32_t value, int count) {
+    for (int i = 0; i < count; ++i) {
+        if (static_cast<uint32_t>(keys[i]) == value) return i;
+    }
+    return -1;
+}
+
+#ifdef DENSE_X86
+template <bool Secondary>
+__attribute__((target("sse4.1"))) uint32_t relaxSse41(const RelaxArgs& a) {
+    const __m128i key = _mm_set1_epi32(a.key);
+    const __m128i room = _mm_set1_epi32(DenseWorkspace::UNREACHED - a.key);
+    const __m128i parent = _mm_set1_epi32(a.parent);
+    const __m128i secondary = _mm_set1_epi32(a.secondary);
+    __m128i best = _mm_set1_epi32(-1);
+    for (int i = 0; i < a.count; i += 4) {
+        __m128i* keys = reinterpret_cast<__m128i*>(a.keys + i);
+        __m128i current = _mm_load_si128(keys);
+        __m128i weight = _mm_load_si128(reinterpret_cast<const __m128i*>(a.weights + i));
+        __m128i candidate = _mm_add_epi32(key, _mm_min_epi32(weight, room));
+        __m128i better = _mm_cmpgt_epi32(current, candidate);
+        if (!_mm_testz_si128(better, better)) {
+            current = _mm_blendv_epi8(current, candidate, better);
+            _mm_store_si128(keys, current);
+            __m128i* parents = reinterpret_cast<__m128i*>(a.parents + i);
+            _mm_store_si128(parents, _mm_blendv_epi8(_mm_load_si128(parents), parent, better));
+            if (Secondary) {
+                __m128i* secondaries = reinterpret_cast<__m128i*>(a.secondaries + i);
+                __m128i total = _mm_add_epi32(secondary, _mm_load_si128(reinterpret_cast<const __m128i*>(a.secondaryWeights + i)));
+                _mm_store_si128(secondaries, _mm_blendv_epi8(_mm_load_si128(secondaries), total, better));
+            }
+        }
+        best = _mm_min_epu32(best, current);
+    }
+    best = _mm_min_epu32(best, _mm_shuffle_epi32(best, 0x4E));
+    best = _mm_min_epu32(best, _mm_shuffle_epi32(best, 0xB1));
+    return static_cast<uint32_t>(_mm_cvtsi128_si32(best));
+}
+
+__attribute__((target("sse4.1"))) int findSse41(const int32_t* keys, uint32_t value, int count) {
+    const __m128i wanted = _mm_set1_epi32(static_cast<int32_t>(value));
+    for (int i = 0; i < count; i += 4) {
+        __m128i equal = _mm_cmpeq_epi32(_mm_load_si128(reinterpret_cast<const __m128i*>(keys + i)), wanted);
+        int mask = _mm_movemask_ps(_mm_castsi128_ps(equal));
+        if (mask) return i + __builtin_ctz(mask);
+    }
+    return -1;
+}
+
+template <bool Secondary>
+__attribute__((target("avx2"))) uint32_t relaxAvx2(const RelaxArgs& a) {
+    const __m256i key = _mm256_set1_epi32(a.key);
+    const __m256i room = _mm256_set1_epi32(DenseWorkspace::UNREACHED - a.key);
+    const __m256i parent = _mm256_set1_epi32(a.parent);
+    const __m256i secondary = _mm256_set1_epi32(a.secondary);
+    __m256i best = _mm256_set1_epi32(-1);
+    for (int i = 0; i < a.count; i += 8) {
+        __m256i* keys = reinterpret_cast<__m256i*>(a.keys + i);
+        __m256i current = _mm256_load_si256(keys);
+        __m256i weight = _mm256_load_si256(reinterpret_cast<const __m256i*>(a.weights + i));
+        __m256i candidate = _mm256_add_epi32(key, _mm256_min_epi32(weight, room));
+        __m256i better = _mm256_cmpgt_epi32(current, candidate);
+        if (!_mm256_testz_si256(better, better)) {
+            current = _mm256_blendv_epi8(current, candidate, better);
+            _mm256_store_si256(keys, current);
+            __m256i* parents = reinterpret_cast<__m256i*>(a.parents + i);
+            _mm256_store_si256(parents, _mm256_blendv_epi8(_mm256_load_si256(parents), parent, better));
+            if (Secondary) {
+                __m256i* secondaries = reinterpret_cast<__m256i*>(a.secondaries + i);
+                __m256i total = _mm256_add_epi32(secondary, _mm256_load_si256(reinterpret_cast<const __m256i*>(a.secondaryWeights + i)));
+                _mm256_store_si256(secondaries, _mm256_blendv_epi8(_mm256_load_si256(secondaries), total, better));
+            }
+        }
+        best = _mm256_min_epu32(best, current);
+    }
+    __m128i half = _mm_min_epu32(_mm256_castsi256_si128(best), _mm256_extracti128_si256(best, 1));
+    half = _mm_min_epu32(half, _mm_shuffle_epi32(half, 0x4E));
+    half = _mm_min_epu32(half, _mm_shuffle_epi32(half, 0xB1));
+    return static_cast<uint32_t>(_mm_cvtsi128_si32(half));
+}
+
+__attribute__((target("avx2"))) int findAvx2(const int32_t* keys, uint32_t value, int count) {
+    const __m256i wanted = _mm256_set1_epi32(static_cast<int32_t>(value));
+    for (int i = 0; i < count; i += 8) {
+        __m256i equal = _mm256_cmpeq_epi32(_mm256_load_si256(reinterpret_cast<const __m256i*>(keys + i)), wanted);
+        int mask = _mm256_movemask_ps(_mm256_castsi256_ps(equal));
+        if (mask) return i + __builtin_ctz(mask);
+    }
+    return -1;
+}
+#endif
+
+// Returns whether this CPU can run the given kernels
+bool supported(DenseIsa isa) {
+#ifdef DENSE_X86
+    if (isa == DenseIsa::Avx2) return __builtin_cpu_supports("avx2");
+    if (isa == DenseIsa::Sse41) return __builtin_cpu_supports("sse4.1");
+#endif
+    return isa == DenseIsa::Scalar;
+}
+
+// Returns the best kernels this CPU supports
+DenseIsa bestIsa() {
+    if (supported(DenseIsa::Avx2)) return DenseIsa::Avx2;
+    if (supported(DenseIsa::Sse41)) return DenseIsa::Sse41;
+    return DenseIsa::Scalar;
+}
+
+std::atomic<DenseIsa> activeIsa{bestIsa()};
+
+// Returns the kernels of the active instruction set
+const Kernels& kernels() {
+    static const Kernels scalar = {relaxScalar<true>, relaxScalar<false>, findScalar};
+#ifdef DENSE_X86
+    static const Kernels sse41 = {relaxSse41<true>, relaxSse41<false>, findSse41};
+    static const Kernels avx2 = {relaxAvx2<true>, relaxAvx2<false>, findAvx2};
+    switch (activeIsa.load(std::memory_order_relaxed)) {
+    case DenseIsa::Avx2:
+        return avx2;
+    case DenseIsa::Sse41:
+        return sse41;
+    case DenseIsa::Scalar:
+        break;
+    }
+#endif
+    return scalar;
+}
+
+// Returns the number of cells a row of n vertices is padded to
+int paddedStride(int n) {
+    return (n + 7) / 8 * 8;
+}
+
+} // namespace
+
+// Returns the instruction set the dense kernels currently use
+DenseIsa denseIsa() {
+    return activeIsa.load();
+}
+
+// Switches the dense kernels to the given instruction set (for benchmarks; call it while no search runs).
+// Returns false, changing nothing, if the CPU lacks it
+bool useDenseIsa(DenseIsa isa) {
+    if (!supported(isa)) return false;
+    activeIsa.store(isa);
+    return true;
+}
+
+// Returns a printable name of an instruction set
+const char* denseIsaName(DenseIsa isa) {
+    switch (isa) {
+    case DenseIsa::Avx2:
+        return "avx2";
+    case DenseIsa::Sse41:
+        return "sse4.1";
+    case DenseIsa::Scalar:
+        break;
+    }
+    return "scalar";
+}
+
+// Returns whether a search expected to examine the given number of flights runs faster on the dense engine.
+// A matrix cell costs the active kernels a fraction of one heap relaxation; the break-even densities (flights
+// per cell) are calibrated against benchmarkDense
+bool preferDense(int vertexCount, long long relaxations) {
+    long long cells = static_cast<long long>(vertexCount) * vertexCount;
+    long long cellsPerRelaxation = 6;
+    if (denseIsa() == DenseIsa::Avx2) cellsPerRelaxation = 32;
+    else if (denseIsa() == DenseIsa::Sse41) cellsPerRelaxation = 16;
+    return vertexCount <= DENSE_MAX_VERTICES && relaxations * cellsPerRelaxation >= cells;
+}
+
+// DenseMatrix methods
+// Builds the directed matrix of a snapshot for one metric, keeping the other metric of each chosen flight. Each
+// row is cleared just before its flights are written, so it is still in cache when they land
+void DenseMatrix::build(const FrozenGraph& g, Metric m) {
+    n = g.vertexCount();
+    rowStride = paddedStride(n);
+    metric = m;
+    weights.resize(static_cast<size_t>(n) * rowStride);
+    secondaryWeights.resize(static_cast<size_t>(n) * rowStride);
+    for (int u = 0; u < n; ++u) {
+        int32_t* cells = weights.data() + static_cast<size_t>(u) * rowStride;
+        int32_t* others = secondaryWeights.data() + static_cast<size_t>(u) * rowStride;
+        std::fill(cells, cells + rowStride, NO_FLIGHT);
+        std::fill(others, others + rowStride, 0);
+        for (int e = g.edgeBegin(u); e < g.edgeEnd(u); ++e) {
+            int v = g.edgeTarget(e);
+            int weight = (metric == Metric::Distance) ? g.edgeDistance(e) : g.edgeCost(e);
+            if (v == u || weight >= cells[v]) continue;
+            cells[v] = weight;
+            others[v] = (metric == Metric::Distance) ? g.edgeCost(e) : g.edgeDistance(e);
+        }
+    }
+}
+
+// Builds the symmetric matrix Prim works on: every flight counts in both directions. Row u is filled from u's
+// outbound and inbound flights, so every write lands in the row being built
+void DenseMatrix::buildUndirected(const FrozenGraph& g, Metric m) {
+    n = g.vertexCount();
+    rowStride = paddedStride(n);
+    metric = m;
+    weights.resize(static_cast<size_t>(n) * rowStride);
+    secondaryWeights.resize(0);
+    for (int u = 0; u < n; ++u) {
+        int32_t* cells = weights.data() + static_cast<size_t>(u) * rowStride;
+        std::fill(cells, cells + rowStride, NO_FLIGHT);
+        for (int e = g.edgeBegin(u); e < g.edgeEnd(u); ++e) {
+            int weight = (metric == Metric::Distance) ? g.edgeDistance(e) : g.edgeCost(e);
+            cells[g.edgeTarget(e)] = std::min(cells[g.edgeTarget(e)], weight);
+        }
+        for (int e = g.reverseBegin(u); e < g.reverseEnd(u); ++e) {
+            int weight = (metric == Metric::Distance) ? g.reverseDistance(e) : g.reverseCost(e);
+            cells[g.reverseSource(e)] = std::min(cells[g.reverseSource(e)], weight);
+        }
+        cells[u] = NO_FLIGHT; // Self-loops never join a tree
+    }
+}
+
+// DenseWorkspace methods
+// Returns this thread's workspace
+DenseWorkspace& DenseWorkspace::local() {
+    thread_local DenseWorkspace workspace;
+    return workspace;
+}
+
+// Starts a new search over vertexCount vertices: every key is UNREACHED, and the padding up to stride is SETTLED
+// so the kernels skip it
+void DenseWorkspace::begin(int vertexCount, int stride) {
+    n = vertexCount;
+    if (keys.size() != static_cast<size_t>(stride)) {
+        finalKeys.assign(stride, 0);
+        secondaries.assign(stride, 0);
+        parents.assign(stride, -1);
+    }
+    keys.assign(stride, SETTLED);
+    std::fill(keys.data(), keys.data() + n, UNREACHED);
+}
+
+// Query engines
+// Dense Dijkstra: each step relaxes the whole matrix row of the vertex just settled, and the same pass returns the
+// smallest remaining key, so finding the next vertex is one more scan for the first lane holding it. Ties settle
+// lowest index first, as in the heap engines, so both return the same routes. Stops once stop(u) returns true for
+// a settled vertex u. With stats, each settled vertex counts a full row of relaxations
+template <typename Stop>
+static void runDense(const DenseMatrix& m, int source, DenseWorkspace& ws, SearchStats* stats, Stop&& stop) {
+    const Kernels& k = kernels();
+    ws.begin(m.vertexCount(), m.stride());
+    int32_t* keys = ws.keyData();
+    int32_t* finalKeys = ws.finalKeyData();
+    RelaxArgs args = {keys, ws.parentData(), ws.secondaryData(), nullptr, nullptr, 0, 0, 0, m.stride()};
+    keys[source] = 0;
+    args.secondaries[source] = 0;
+    args.parents[source] = -1;
+
+    int u = source;
+    for (;;) {
+        finalKeys[u] = keys[u];
+        keys[u] = DenseWorkspace::SETTLED;
+        if (stats) {
+            stats->settled++;
+            stats->relaxed += m.vertexCount();
+        }
+        if (stop(u)) break;
+
+        args.weights = m.row(u);
+        args.secondaryWeights = m.secondaryRow(u);
+        args.key = finalKeys[u];
+        args.secondary = args.secondaries[u];
+        args.parent = u;
+        uint32_t best = k.relax(args);
+        if (best >= static_cast<uint32_t>(DenseWorkspace::UNREACHED)) break;
+        u = k.find(keys, best, m.stride());
+    }
+}
+
+// Dense Dijkstra from source over a directed matrix, stopping once target settles (-1 searches everything)
+void denseDijkstra(const DenseMatrix& m, int source, int target, DenseWorkspace& ws, SearchStats* stats) {
+    runDense(m, source, ws, stats, [target](int u) { return u == target; });
+}
+
+// Dense Dijkstra from source, stopping once every target has settled
+void denseDijkstraToTargets(const DenseMatrix& m, int source, const std::vector<int>& targets, DenseWorkspace& ws,
+                            SearchStats* stats) {
+    thread_local std::vector<char> isTarget;
+    if (isTarget.size() < m.vertexCount()) isTarget.resize(m.vertexCount(), 0);
+    int remaining = 0;
+    for (int t : targets) {
+        if (!isTarget[t]) remaining++;
+        isTarget[t] = 1;
+    }
+    runDense(m, source, ws, stats, [&](int u) { return isTarget[u] && --remaining == 0; });
+    for (int t : targets) isTarget[t] = 0;
+}
+
+// Reads the route to destination off a dense search. Returns false if destination did not settle
+bool extractDenseRoute(const DenseMatrix& m, const DenseWorkspace& ws, int destination, RouteResult& result) {
+    result.path.clear();
+    result.found = ws.settled(destination);
+    if (!result.found) return false;
+
+    int hops = 0;
+    for (int at = destination; at != -1; at = ws.parent(at)) ++hops;
+    result.path.resize(hops);
+    for (int at = destination; at != -1; at = ws.parent(at)) result.path[--hops] = at;
+
+    bool byDistance = m.getMetric() == Metric::Distance;
+    result.distance = byDistance ? ws.key(destination) : ws.secondary(destination);
+    result.cost = byDistance ? ws.secondary(destination) : ws.key(destination);
+    return true;
+}
+
+// Dense Prim over a symmetric matrix. Fills order with the vertices in the order they join the forest; each
+// component grows from its lowest unreached vertex, and a vertex's parent and key are its tree edge
+void densePrim(const DenseMatrix& m, DenseWorkspace& ws, std::vector<int>& order) {
+    const Kernels& k = kernels();
+    int n = m.vertexCount();
+    order.clear();
+    ws.begin(n, m.stride());
+    int32_t* keys = ws.keyData();
+    int32_t* finalKeys = ws.finalKeyData();
+    RelaxArgs args = {keys, ws.parentData(), nullptr, nullptr, nullptr, 0, 0, 0, m.stride()};
+
+    while (static_cast<int>(order.size()) < n) {
+        int u = k.find(keys, DenseWorkspace::UNREACHED, m.stride());
+        keys[u] = 0;
+        args.parents[u] = -1;
+        for (;;) {
+            finalKeys[u] = keys[u];
+            keys[u] = DenseWorkspace::SETTLED;
+            order.push_back(u);
+
+            args.weights = m.row(u);
+            args.parent = u;
+            uint32_t best = k.relaxKeys(args);
+            if (best >= static_cast<uint32_t>(DenseWorkspace::UNREACHED)) break;
+            u = k.find(keys, best, m.stride());
+        }
+    }
+}
@@ -0,0 +1,112 @@
+#ifndef DENSE_H
+#define DENSE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include "routing.h"
+
+class FrozenGraph;
+
+// Instruction sets the dense kernels are compiled for. The best one the CPU supports is picked on first use
+enum class DenseIsa { Scalar, Sse41, Avx2 };
+
+// 64-byte aligned int32 buffer, so every SIMD load of a padded row is aligned
+class AlignedInts {
+private:
+    int32_t* values = nullptr;
+    size_t count = 0;
+
+public:
+    AlignedInts() = default;
+    AlignedInts(const AlignedInts&) = delete;
+    AlignedInts& operator=(const AlignedInts&) = delete;
+    ~AlignedInts();
+
+    void resize(size_t size);
+    void assign(size_t size, int32_t value);
+    int32_t* data() { return values; }
+    const int32_t* data() const { return values; }
+    size_t size() const { return count; }
+    int32_t& operator[](size_t i) { return values[i]; }
+    int32_t operator[](size_t i) const { return values[i]; }
+};
+
+// V x V weight matrix for the dense engines. Cell (u, v) holds the weight of the lightest flight u -> v under one
+// metric (the first such flight on ties, as the heap engines pick) and NO_FLIGHT where there is none. Rows are
+// padded to a multiple of 8 cells so the kernels need no scalar tail
+class DenseMatrix {
+public:
+    static constexpr int32_t NO_FLIGHT = INT32_MAX;
+
+private:
+    int n = 0;
+    int rowStride = 0;
+    Metric metric = Metric::Distance;
+    AlignedInts weights;
+    AlignedInts secondaryWeights; // The other metric of the same flight (directed matrices only)
+
+public: // See implementation file for details
+    void build(const FrozenGraph& g, Metric metric);
+    void buildUndirected(const FrozenGraph& g, Metric metric);
+
+    int vertexCount() const { return n; }
+    int stride() const { return rowStride; }
+    Metric getMetric() const { return metric; }
+    const int32_t* row(int u) const { return weights.data() + static_cast<size_t>(u) * rowStride; }
+    const int32_t* secondaryRow(int u) const { return secondaryWeights.data() + static_cast<size_t>(u) * rowStride; }
+    size_t memoryBytes() const { return (weights.size() + secondaryWeights.size()) * sizeof(int32_t); }
+};
+
+// Lazily built directed matrices of a frozen graph, one per metric, shared by copies of the snapshot
+struct DenseMatrices {
+    std::once_flag built[2];
+    DenseMatrix matrices[2];
+};
+
+// Per-thread state of the dense engines. Keys live in one aligned array: a settled vertex is marked by the
+// SETTLED sentinel (all bits set, so it is the largest key as unsigned and below every key as signed), which lets
+// one vector compare both skip it when relaxing and when picking the next vertex
+class DenseWorkspace {
+public:
+    static constexpr int32_t SETTLED = -1;
+    static constexpr int32_t UNREACHED = INT32_MAX;
+
+private:
+    int n = 0;
+    AlignedInts keys;          // Tentative keys, UNREACHED or SETTLED
+    AlignedInts finalKeys;     // Key of each vertex when it settled
+    AlignedInts secondaries;   // The other metric along the current route
+    AlignedInts parents;
+
+public: // See implementation file for details
+    static DenseWorkspace& local();
+
+    void begin(int vertexCount, int stride);
+    bool settled(int v) const { return keys[v] == SETTLED; }
+    int key(int v) const { return finalKeys[v]; }
+    int secondary(int v) const { return secondaries[v]; }
+    int parent(int v) const { return parents[v]; }
+
+    // Raw arrays for the kernels
+    int32_t* keyData() { return keys.data(); }
+    int32_t* finalKeyData() { return finalKeys.data(); }
+    int32_t* secondaryData() { return secondaries.data(); }
+    int32_t* parentData() { return parents.data(); }
+};
+
+// Kernel selection and engine choice
+DenseIsa denseIsa();
+bool useDenseIsa(DenseIsa isa);
+const char* denseIsaName(DenseIsa isa);
+bool preferDense(int vertexCount, long long relaxations);
+
+// Array-based O(V^2) engines over a DenseMatrix
+void denseDijkstra(const DenseMatrix& m, int source, int target, DenseWorkspace& ws, SearchStats* stats = nullptr);
+void denseDijkstraToTargets(const DenseMatrix& m, int source, const std::vector<int>& targets, DenseWorkspace& ws,
+                            SearchStats* stats = nullptr);
+bool extractDenseRoute(const DenseMatrix& m, const DenseWorkspace& ws, int destination, RouteResult& result);
+void densePrim(const DenseMatrix& m, DenseWorkspace& ws, std::vector<int>& order);
+
+#endif
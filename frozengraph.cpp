@@ -0,0 +1,400 @@
+#include "frozengraph.h"
+#include "allpairs.h"
+#include "contraction.h"
+#include "pareto.h"
+#include "kshortest.h"
+#include "spanning.h"
+#include "querycache.h"
+#include "metrics.h"
+#include <algorithm>
+#include <iostream>
+#include <limits>
+
+// Most hop-layer labels an exact stop count may ask for (about 20 bytes each); see maxExactStops
+const size_t HOP_LABEL_BUDGET = size_t(1) << 24;
+
+// Snapshot accessors
+// Attempts to find and return the index of the given airport code. If not found, returns -1
+int FrozenGraph::getAirportIndex(const std::string& code) const {
+    return airports.find(code);
+}
+
+// Returns the airport code of the given vertex
+std::string FrozenGraph::getAirportCode(int index) const {
+    return airports.code(index);
+}
+
+// Returns the state of the given vertex
+std::string_view FrozenGraph::getState(int index) const {
+    return airports.state(index);
+}
+
+// Returns the id of the given state, or -1 if no airport is in it
+int FrozenGraph::getStateId(std::string_view state) const {
+    return airports.findState(state);
+}
+
+// Groups the airports of each interned state with a counting sort, O(V)
+void FrozenGraph::buildStateIndex() {
+    int n = vertexCount();
+    int stateTotal = airports.stateCount();
+    stateOffsets.assign(stateTotal + 1, 0);
+    for (int v = 0; v < n; ++v) stateOffsets[airports.stateId(v) + 1]++;
+    for (int s = 0; s < stateTotal; ++s) stateOffsets[s + 1] += stateOffsets[s];
+    stateAirports.resize(n);
+    std::vector<int> fill(stateOffsets.begin(), stateOffsets.end() - 1);
+    for (int v = 0; v < n; ++v) stateAirports[fill[airports.stateId(v)]++] = v;
+}
+
+// Makes point-to-point queries use the given landmark index (pass nullptr to go back to plain Dijkstra).
+// The index must have been built on this snapshot
+void FrozenGraph::attachLandmarks(std::shared_ptr<const LandmarkIndex> index) {
+    landmarks = std::move(index);
+}
+
+// Makes point-to-point queries by the hierarchy's metric search it (pass nullptr to go back to the other engines).
+// The hierarchy must have been built on, or loaded for, this snapshot
+void FrozenGraph::attachHierarchy(std::shared_ptr<const ContractionHierarchy> index) {
+    hierarchy = std::move(index);
+}
+
+// Makes route and state queries by the table's metric read it instead of searching. The table must have been
+// built on this snapshot
+void FrozenGraph::attachAllPairs(std::shared_ptr<const AllPairsTable> table) {
+    if (table) allPairs[static_cast<int>(table->getMetric())] = std::move(table);
+}
+
+// Returns the attached all-pairs table of the given metric, or nullptr if there is none for this snapshot
+const AllPairsTable* FrozenGraph::allPairsTable(Metric metric) const {
+    const AllPairsTable* table = allPairs[static_cast<int>(metric)].get();
+    return (table && table->vertexCount() == vertexCount()) ? table : nullptr;
+}
+
+// Returns the dense weight matrix of the given metric, building it on first use, or nullptr when the graph is too
+// large or too sparse for the dense engine to beat the heap. Only searches that settle much of the graph use it:
+// a bidirectional point-to-point query settles so little that it stays ahead of the dense scans at any density
+const DenseMatrix* FrozenGraph::denseMatrix(Metric metric) const {
+    if (!preferDense(vertexCount(), edgeCount())) return nullptr;
+    int slot = (metric == Metric::Distance) ? 0 : 1;
+    std::call_once(dense->built[slot], [&] { dense->matrices[slot].build(*this, metric); });
+    return &dense->matrices[slot];
+}
+
+// Makes the data-returning queries consult and fill the given cache (pass nullptr to stop caching). Entries are
+// keyed by this snapshot's graph version, so one cache can be shared by successive snapshots of a graph
+void FrozenGraph::attachCache(std::shared_ptr<QueryCache> queryCache) {
+    cache = std::move(queryCache);
+}
+
+// Builds the inbound CSR arrays from the outbound ones with a counting sort, O(V + E)
+void FrozenGraph::buildReverseEdges() {
+    int n = vertexCount();
+    std::vector<int> offsets(n + 1, 0);
+    for (int target : edgeTargets) {
+        offsets[target + 1]++;
+    }
+    for (int v = 0; v < n; ++v) {
+        offsets[v + 1] += offsets[v];
+    }
+
+    std::vector<int> sources(edgeTargets.size());
+    std::vector<int> distances(edgeTargets.size());
+    std::vector<int> costs(edgeTargets.size());
+    std::vector<int> next(offsets.begin(), offsets.end() - 1);
+    for (int u = 0; u < n; ++u) {
+        for (int e = edgeOffsets[u]; e < edgeOffsets[u + 1]; ++e) {
+            int slot = next[edgeTargets[e]]++;
+            sources[slot] = u;
+            distances[slot] = edgeDistances[e];
+            costs[slot] = edgeCosts[e];
+        }
+    }
+    reverseOffsets = std::move(offsets);
+    reverseSources = std::move(sources);
+    reverseDistances = std::move(distances);
+    reverseCosts = std::move(costs);
+}
+
+// Prints a path of vertex indices as "AAA -> BBB -> CCC"
+void FrozenGraph::printPath(const std::vector<int>& path) const {
+    for (size_t i = 0; i < path.size(); ++i) {
+        std::cout << airports.code(path[i]);
+        if (i != path.size() - 1) std::cout << " -> ";
+    }
+}
+
+// Query engines
+// Returns the shortest route between two airport indices by the given metric: a table lookup when an all-pairs
+// table is attached, else a hierarchy search when a contraction hierarchy for the metric is, else landmark-guided
+// A* when a landmark index is, else bidirectional dijkstra's algorithm
+RouteResult FrozenGraph::shortestRoute(int origin, int destination, Metric metric, SearchStats* requested) const {
+    QueryTimer timer(QueryMetrics::Query::Route, requested);
+    SearchStats* stats = timer.stats();
+    QueryKey key;
+    if (cache) {
+        key.kind = QueryKey::Kind::Route;
+        key.metric = metric;
+        key.origin = origin;
+        key.destination = destination;
+        if (QueryCache::Result hit = cache->find(key, version)) return hit->front();
+    }
+
+    RouteResult result;
+    if (const AllPairsTable* table = allPairsTable(metric)) {
+        result = table->route(origin, destination);
+    } else if (hierarchy && hierarchy->vertexCount() == vertexCount() && hierarchy->getMetric() == metric) {
+        result = hierarchy->route(origin, destination);
+    } else if (landmarks && landmarks->vertexCount() == vertexCount()) {
+        result = landmarks->route(*this, origin, destination, metric, stats);
+    } else {
+        SearchWorkspace& forward = SearchWorkspace::local(0);
+        SearchWorkspace& backward = SearchWorkspace::local(1);
+        bidirectionalDijkstra(*this, origin, destination, forward, backward, result, metric, stats);
+    }
+    if (cache) cache->insert(key, version, {result});
+    return result;
+}
+
+// Returns the shortest routes from an airport index to every reachable airport in the given state, in vertex order.
+// One search runs until every reachable airport of the state is settled, and all routes are read off its
+// predecessor tree, so a query to a small state nearby touches a small part of the graph
+std::vector<RouteResult> FrozenGraph::shortestRoutesToState(int origin, const std::string& state, Metric metric,
+                                                            SearchStats* requested) const {
+    QueryTimer timer(QueryMetrics::Query::RoutesToState, requested);
+    SearchStats* stats = timer.stats();
+    QueryKey key;
+    if (cache) {
+        key.kind = QueryKey::Kind::RoutesToState;
+        key.metric = metric;
+        key.origin = origin;
+        key.state = state;
+        if (QueryCache::Result hit = cache->find(key, version)) return *hit;
+    }
+
+    std::vector<RouteResult> results;
+    int id = getStateId(state);
+    thread_local std::vector<int> targets;
+    targets.clear();
+    for (int i = (id == -1) ? 0 : stateBegin(id); id != -1 && i < stateEnd(id); ++i) {
+        if (mayReach(origin, stateAirport(i))) targets.push_back(stateAirport(i));
+    }
+    const AllPairsTable* table = allPairsTable(metric);
+    const DenseMatrix* matrix = (targets.empty() || table) ? nullptr : denseMatrix(metric);
+    if (table) {
+        for (int dst : targets) {
+            if (table->reachable(origin, dst)) results.push_back(table->route(origin, dst));
+        }
+    } else if (matrix) {
+        DenseWorkspace& ws = DenseWorkspace::local();
+        denseDijkstraToTargets(*matrix, origin, targets, ws, stats);
+        for (int dst : targets) {
+            if (!ws.settled(dst)) continue;
+            results.emplace_back();
+            extractDenseRoute(*matrix, ws, dst, results.back());
+        }
+    } else if (!targets.empty()) {
+        SearchWorkspace& ws = SearchWorkspace::local();
+        dijkstraToTargets(*this, origin, targets, ws, metric, stats);
+        for (int dst : targets) {
+            if (!ws.settled(dst)) continue;
+            results.emplace_back();
+            extractRoute(ws, dst, results.back());
+        }
+    }
+    if (cache) cache->insert(key, version, results);
+    return results;
+}
+
+// Returns the largest exact stop count shortestRouteWithStops accepts. The hop layers hold V labels per flight
+// of the route, so the limit keeps them within HOP_LABEL_BUDGET labels
+int FrozenGraph::maxExactStops() const {
+    size_t layers = HOP_LABEL_BUDGET / std::max(1, vertexCount());
+    return static_cast<int>(std::min<size_t>(std::numeric_limits<int>::max() - 2, std::max<size_t>(layers, 2) - 2));
+}
+
+// Returns the shortest route between two airport indices with exactly (or at most) the given number of intermediate stops.
+// Routes may revisit airports. The hop layers are sized by the stop count, so an "at most" limit is clamped to
+// V - 2 (the best such route never revisits an airport) and an exact count above maxExactStops() throws
+RouteResult FrozenGraph::shortestRouteWithStops(int origin, int destination, int stops, bool exactStops, Metric metric,
+                                                SearchStats* requested) const {
+    if (exactStops && stops > maxExactStops()) {
+        throw std::string("Too many stops (at most ") + std::to_string(maxExactStops()) + " for an exact count)";
+    }
+    if (!exactStops) stops = std::min(stops, std::max(0, vertexCount() - 2));
+    QueryTimer timer(QueryMetrics::Query::RouteWithStops, requested);
+    SearchStats* stats = timer.stats();
+    QueryKey key;
+    if (cache) {
+        key.kind = QueryKey::Kind::RouteWithStops;
+        key.metric = metric;
+        key.origin = origin;
+        key.destination = destination;
+        key.hops = stops;
+        key.exactHops = exactStops;
+        if (QueryCache::Result hit = cache->find(key, version)) return hit->front();
+    }
+
+    RouteResult result;
+    if (stops >= 0 && mayReach(origin, destination)) {
+        HopLayers& layers = HopLayers::local();
+        hopLimitedSearch(*this, origin, stops + 1, layers, metric, destination, stats);
+        int hops = exactStops ? stops + 1 : layers.bestHops(destination, 1);
+        extractHopRoute(layers, destination, hops, result);
+    }
+    if (cache) cache->insert(key, version, {result});
+    return result;
+}
+
+// Returns the (distance, cost) Pareto frontier of routes between two airport indices, by increasing distance
+std::vector<RouteResult> FrozenGraph::paretoRoutes(int origin, int destination) const {
+    return ::paretoRoutes(*this, origin, destination, ParetoWorkspace::local());
+}
+
+// Returns up to k loopless routes between two airport indices by increasing metric, alternatives to shortestRoute.
+// With a pool, the spur searches of each round run in parallel
+std::vector<RouteResult> FrozenGraph::kShortestRoutes(int origin, int destination, int k, Metric metric, ThreadPool* pool) const {
+    return ::kShortestRoutes(*this, origin, destination, k, metric, pool);
+}
+
+// Calculates and prints the shortest path between the given origin and destination airports (dijkstra's algorithm)
+void FrozenGraph::shortestPath(const std::string& origin, const std::string& destination) const {
+    // Get source and destination airport index
+    int i_src = getAirportIndex(origin);
+    int i_dest = getAirportIndex(destination);
+    
+    // Index validation
+    if (i_src == -1 || i_dest == -1) {
+        throw std::string("Shortest path: incorrect vertices"); 
+    }
+
+    RouteResult route = shortestRoute(i_src, i_dest);
+
+    // No path available
+    if (!route.found) {
+        std::cout << "Shortest route from " << origin << " to " << destination << ": " << "N/A" << std::endl;
+        return;
+    }
+
+    // Output shortest route
+    std::cout << "Shortest route from " << origin << " to " << destination << ": ";
+    printPath(route.path);
+    // Output distance and cost
+    std::cout << ". The length is " << route.distance << ".";
+    std::cout << " The cost is " << route.cost << "." << std::endl;
+}
+
+// Calculates and prints all shortest paths between the given origin airport and all destination airports in a given state (dijkstra's algorithm)
+void FrozenGraph::shortestPathsToState(const std::string& origin, const std::string& state) const {
+    // Get source airport index
+    int src = getAirportIndex(origin);
+    
+    // Index validation
+    if (src == -1) {
+        std::cout << "Invalid origin airport." << std::endl;
+        return;
+    }
+    
+    std::vector<RouteResult> routes = shortestRoutesToState(src, state);
+
+    // Print routes
+    std::cout << "Shortest path from " << origin << " to " << state << " state airports are:" << std::endl;
+    for (const auto& route : routes) {
+        printPath(route.path);
+        // Print distance and cost of route
+        std::cout << " | Length = " << route.distance << ", Cost = " << route.cost << std::endl;
+    }
+    
+    // No paths found
+    if (routes.empty()) {
+        std::cout << "N/A" << std::endl;
+    }
+}
+
+// Calculates and prints the shortest path between the given origin and destination airport with a specified amount of stops
+void FrozenGraph::shortestPathWithStops(const std::string& origin, const std::string& destination, int stops) const {
+    // Get source and destination airport index
+    int src = getAirportIndex(origin);
+    int dst = getAirportIndex(destination);
+    // Index validation
+    if (src == -1 || dst == -1) {
+        std::cout << "Invalid airport codes." << std::endl;
+        return;
+    }
+    if (stops > maxExactStops()) {
+        std::cout << "Too many stops (at most " << maxExactStops() << ")." << std::endl;
+        return;
+    }
+
+    RouteResult route = shortestRouteWithStops(src, dst, stops, true);
+
+    // Print results
+    std::cout << "Shortest path from " << origin << " to " << destination << " with " << stops << " stops: ";
+    
+    // No path found
+    if (!route.found) {
+        std::cout << "N/A" << std::endl;
+        return;
+    }
+    
+    // Path found; print path
+    printPath(route.path);
+    std::cout << ". The length is " << route.distance << ". The cost is " << route.cost << std::endl;
+}
+
+// Calculates and prints the k shortest loopless routes between the given origin and destination airports (Yen's algorithm)
+void FrozenGraph::kShortestPaths(const std::string& origin, const std::string& destination, int k) const {
+    // Get source and destination airport index
+    int src = getAirportIndex(origin);
+    int dst = getAirportIndex(destination);
+    // Index validation
+    if (src == -1 || dst == -1) {
+        std::cout << "Invalid airport codes." << std::endl;
+        return;
+    }
+
+    std::vector<RouteResult> routes = kShortestRoutes(src, dst, k);
+
+    // Print routes, shortest first
+    std::cout << "Top " << k << " routes from " << origin << " to " << destination << ":" << std::endl;
+    for (size_t i = 0; i < routes.size(); ++i) {
+        std::cout << i + 1 << ". ";
+        printPath(routes[i].path);
+        std::cout << " | Length = " << routes[i].distance << ", Cost = " << routes[i].cost << std::endl;
+    }
+
+    // No routes found
+    if (routes.empty()) {
+        std::cout << "N/A" << std::endl;
+    }
+}
+
+// Creates an MST using Prim's algorithm on an undirected snapshot.
+// The given airport data is disconnected, so this prints the minimum spanning forest: one tree per component.
+void FrozenGraph::primMST() const {
+    // Empty graphs can't make MSTs
+    if (vertexCount() == 0) {
+        std::cout << "Graph is empty. MST cannot be formed." << std::endl;
+        return;
+    }
+
+    SpanningForest forest = primForest(*this);
+
+    // Print MST
+    std::cout << "Minimal Spanning Tree (Prim): " << forest.trees.size() << " component(s)" << std::endl;
+    for (const auto& edge : forest.edges) {
+        std::cout << airports.code(edge.u) << " - " << airports.code(edge.v) << " | Weight: " << edge.weight << std::endl;
+    }
+    std::cout << "Total cost of MST: " << forest.weight << std::endl;
+}
+
+// Creates an MST using Kruskal's algorithm on an undirected graph.
+void FrozenGraph::kruskalMST() const {
+    SpanningForest forest = kruskalForest(*this);
+
+    // Print MST
+    std::cout << "Minimal Spanning Tree (Kruskal): " << std::endl;
+    for (const auto& edge : forest.edges) {
+        std::cout << airports.code(edge.u) << " - " << airports.code(edge.v) << " | Weight: " << edge.weight << std::endl;
+    }
+    std::cout << "Total cost of MST: " << forest.weight << std::endl;
+}
@@ -0,0 +1,153 @@
+#ifndef FROZENGRAPH_H
+#define FROZENGRAPH_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <utility>
+#include "routing.h"
+#include "connectivity.h"
+#include "dense.h"
+#include "landmarks.h"
+#include "metadata.h"
+
+class AllPairsTable;
+class ContractionHierarchy;
+class QueryCache;
+class ThreadPool;
+
+// Read-only int array that either owns its values or views memory owned elsewhere (a mapped snapshot file)
+class IntArray {
+private:
+    std::vector<int> owned;
+    const int* values = nullptr;
+    size_t count = 0;
+
+public:
+    IntArray() = default;
+    IntArray(std::vector<int> v) : owned(std::move(v)), values(owned.data()), count(owned.size()) {}
+    IntArray(const int* view, size_t size) : values(view), count(size) {}
+    IntArray(const IntArray& other) : owned(other.owned), values(other.owned.empty() ? other.values : owned.data()), count(other.count) {}
+    IntArray(IntArray&& other) = default; // Moving a vector keeps its buffer, so the view stays valid
+    IntArray& operator=(IntArray other) {
+        owned.swap(other.owned);
+        std::swap(values, other.values);
+        std::swap(count, other.count);
+        return *this;
+    }
+
+    int operator[](size_t i) const { return values[i]; }
+    size_t size() const { return count; }
+    const int* data() const { return values; }
+    const int* begin() const { return values; }
+    const int* end() const { return values + count; }
+};
+
+// Read-only compressed sparse row (CSR) snapshot of a Graph, built by Graph::freeze().
+// Adjacency lists are packed into contiguous structure-of-arrays edge storage so relaxation
+// loops scan memory linearly, and airport metadata is kept apart from the edge data.
+class FrozenGraph {
+private:
+    friend class Graph;
+    friend class GraphSnapshot;
+
+    // Keeps a mapped snapshot file alive while any array views it
+    std::shared_ptr<const void> backing;
+
+    // Vertex metadata (only touched when printing or resolving codes and states)
+    AirportMetadata airports;
+
+    // The airports of state id s are stateAirports[stateOffsets[s], stateOffsets[s + 1]), in index order
+    std::vector<int> stateOffsets{0};
+    std::vector<int> stateAirports;
+
+    // Edge storage. The outbound edges of vertex v are [edgeOffsets[v], edgeOffsets[v + 1])
+    IntArray edgeOffsets{std::vector<int>{0}};
+    IntArray edgeTargets;
+    IntArray edgeDistances;
+    IntArray edgeCosts;
+
+    // Reverse edge storage. The inbound edges of vertex v are [reverseOffsets[v], reverseOffsets[v + 1])
+    IntArray reverseOffsets{std::vector<int>{0}};
+    IntArray reverseSources;
+    IntArray reverseDistances;
+    IntArray reverseCosts;
+
+    // Component reachability; queries between airports it rules out return immediately
+    std::shared_ptr<const ConnectivityIndex> connectivity;
+
+    // Optional ALT index; when attached, point-to-point queries run A* instead of Dijkstra
+    std::shared_ptr<const LandmarkIndex> landmarks;
+
+    // Optional contraction hierarchy; when attached, point-to-point queries by its metric search it instead
+    std::shared_ptr<const ContractionHierarchy> hierarchy;
+
+    // Optional all-pairs tables, one per metric; when attached, route and state queries are table lookups
+    std::shared_ptr<const AllPairsTable> allPairs[2];
+
+    // Dense weight matrices, built on first use when the graph is small and dense enough for the dense engine
+    std::shared_ptr<DenseMatrices> dense = std::make_shared<DenseMatrices>();
+
+    // Graph version this snapshot was taken at, and an optional result cache keyed by it
+    uint64_t version = 0;
+    std::shared_ptr<QueryCache> cache;
+
+    void buildReverseEdges();
+    void buildStateIndex();
+    void printPath(const std::vector<int>& path) const;
+
+public: // See implementation file for details
+    // Snapshot accessors
+    int vertexCount() const { return airports.size(); }
+    int edgeCount() const { return static_cast<int>(edgeTargets.size()); }
+    int edgeBegin(int v) const { return edgeOffsets[v]; }
+    int edgeEnd(int v) const { return edgeOffsets[v + 1]; }
+    int edgeTarget(int e) const { return edgeTargets[e]; }
+    int edgeDistance(int e) const { return edgeDistances[e]; }
+    int edgeCost(int e) const { return edgeCosts[e]; }
+    int reverseBegin(int v) const { return reverseOffsets[v]; }
+    int reverseEnd(int v) const { return reverseOffsets[v + 1]; }
+    int reverseSource(int e) const { return reverseSources[e]; }
+    int reverseDistance(int e) const { return reverseDistances[e]; }
+    int reverseCost(int e) const { return reverseCosts[e]; }
+    bool mayReach(int from, int to) const { return !connectivity || connectivity->mayReach(from, to); }
+    int getAirportIndex(const std::string& code) const;
+    std::string getAirportCode(int index) const;
+    std::string_view getState(int index) const;
+    int stateCount() const { return airports.stateCount(); }
+    int getStateId(std::string_view state) const;
+    int getStateIdOf(int index) const { return airports.stateId(index); }
+    std::string_view getStateName(int id) const { return airports.stateName(id); }
+    int stateBegin(int id) const { return stateOffsets[id]; }
+    int stateEnd(int id) const { return stateOffsets[id + 1]; }
+    int stateAirport(int i) const { return stateAirports[i]; }
+    const DenseMatrix* denseMatrix(Metric metric) const;
+    void attachLandmarks(std::shared_ptr<const LandmarkIndex> index);
+    void attachHierarchy(std::shared_ptr<const ContractionHierarchy> index);
+    void attachAllPairs(std::shared_ptr<const AllPairsTable> table);
+    const AllPairsTable* allPairsTable(Metric metric) const;
+    void attachCache(std::shared_ptr<QueryCache> queryCache);
+    uint64_t getVersion() const { return version; }
+
+    // Query engines returning data
+    RouteResult shortestRoute(int origin, int destination, Metric metric = Metric::Distance, SearchStats* stats = nullptr) const;
+    std::vector<RouteResult> shortestRoutesToState(int origin, const std::string& state, Metric metric = Metric::Distance,
+                                                   SearchStats* stats = nullptr) const;
+    int maxExactStops() const;
+    RouteResult shortestRouteWithStops(int origin, int destination, int stops, bool exactStops, Metric metric = Metric::Distance,
+                                       SearchStats* stats = nullptr) const;
+    std::vector<RouteResult> paretoRoutes(int origin, int destination) const;
+    std::vector<RouteResult> kShortestRoutes(int origin, int destination, int k, Metric metric = Metric::Distance,
+                                             ThreadPool* pool = nullptr) const;
+
+    // Printing query engines (same output as the Graph methods of the same name)
+    void shortestPath(const std::string& origin, const std::string& destination) const;
+    void shortestPathsToState(const std::string& origin, const std::string& state) const;
+    void shortestPathWithStops(const std::string& origin, const std::string& destination, int maxStops) const;
+    void kShortestPaths(const std::string& origin, const std::string& destination, int k) const;
+    void primMST() const;
+    void kruskalMST() const;
+};
+
+#endif
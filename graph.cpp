@@ -1,34 +1,121 @@
 #include "graph.h"
+#include "allpairs.h"
+#include "threadpool.h"
+#include "querycache.h"
+#include <atomic>
 #include <iostream>
+#include <algorithm>
 using namespace std;
 
 // Queue methods
+// Appends a node at the tail, doubling the ring (and unwrapping it) when full
 void Queue::push(int index, int distance, int cost, int stops, const std::vector<int>& path) {
-    data.push_back({index, distance, cost, stops, path});
+    if (count == data.size()) {
+        std::vector<Node> grown(std::max<size_t>(8, data.size() * 2));
+        for (size_t i = 0; i < count; ++i) {
+            grown[i] = std::move(data[(head + i) % data.size()]);
+        }
+        data.swap(grown);
+        head = 0;
+    }
+    data[(head + count) % data.size()] = {index, distance, cost, stops, path};
+    count++;
 }
 
+// Removes and returns the node at the head in O(1)
 Queue::Node Queue::pop() {
-    Node node = data.front();
-    data.erase(data.begin());
+    Node node = std::move(data[head]);
+    head = (head + 1) % data.size();
+    count--;
     return node;
 }
 
 bool Queue::empty() const {
-    return data.empty();
+    return count == 0;
 }
 
 // Graph methods
-// Adds an airport to the graph (vertex object)
-void Graph::addAirport(const std::string& code, const std::string& state) {
-    for (const auto& vertex : vertices) { // Check to see if airport code already exists in graph
-        if (vertex.airportCode == code) return;
+// Drops every view derived from the graph (snapshot, undirected view) after a change and moves the graph to a new
+// version. Versions come from one process-wide counter, so copies of a graph that share a query cache never
+// mistake each other's results for their own
+void Graph::invalidateViews() {
+    static std::atomic<uint64_t> nextVersion{1};
+    snapshotStale = true;
+    undirectedCache.reset();
+    version = nextVersion.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Interns an airport code, creating its vertex if needed, and returns its index
+int Graph::internAirport(std::string_view code, std::string_view state, std::string_view city) {
+    auto inserted = airports.insert(code, state, city);
+    if (!inserted.second) return inserted.first; // Airport code already exists in graph
+
+    // New airport: give it an empty flight list
+    adjacency.emplace_back();
+    degrees.addVertex();
+    invalidateViews();
+    if (!connectivityStale && !connectivity.addVertex()) connectivityStale = true;
+    return inserted.first;
+}
+
+// Reserves room for the given number of airports so bulk loads don't keep rehashing/reallocating
+void Graph::reserve(size_t airportCount) {
+    airports.reserve(airportCount);
+    adjacency.reserve(airportCount);
+}
+
+// Adds a batch of flights (and any airports they mention) in time linear in the number of rows
+template <typename Record>
+void Graph::addFlightBatch(const std::vector<Record>& flights) {
+    // Routes share airports heavily, so one slot per row comfortably covers new codes without rehashing mid-load
+    airports.reserve(adjacency.size() + flights.size());
+
+    // Resolve both endpoints of every row once
+    std::vector<std::pair<int, int>> endpoints;
+    endpoints.reserve(flights.size());
+    for (const auto& flight : flights) {
+        int originIndex = internAirport(flight.origin, flight.originState, flight.originCity);
+        int destIndex = internAirport(flight.dest, flight.destState, flight.destCity);
+        endpoints.push_back({originIndex, destIndex});
+    }
+
+    // Size each adjacency list exactly once
+    std::vector<int> outbound(adjacency.size(), 0);
+    for (const auto& endpoint : endpoints) {
+        outbound[endpoint.first]++;
+    }
+    for (int i = 0; i < adjacency.size(); ++i) {
+        if (outbound[i] > 0) {
+            adjacency[i].reserve(adjacency[i].size() + outbound[i]);
+        }
+    }
+
+    // Add edges in input order
+    for (size_t i = 0; i < flights.size(); ++i) {
+        Edge e;
+        e.destIndex = endpoints[i].second;
+        e.distance = flights[i].distance;
+        e.cost = flights[i].cost;
+        adjacency[endpoints[i].first].push_back(e);
+        degrees.addEdge(endpoints[i].first, endpoints[i].second);
     }
-    
-    // Create new vertex, set airport code & state, and add it to vertices vector
-    Vertex newVertex;
-    newVertex.airportCode = code;
-    newVertex.state = state;
-    vertices.push_back(newVertex);
+    invalidateViews();
+    connectivityStale = true; // One rebuild for the whole batch is cheaper than updating per row
+}
+
+// Adds a batch of owned flight rows
+void Graph::addFlights(const std::vector<FlightRecord>& flights) {
+    addFlightBatch(flights);
+}
+
+// Adds a batch of flight rows viewing caller-owned text; the strings are copied only for new airports
+void Graph::addFlights(const std::vector<FlightView>& flights) {
+    addFlightBatch(flights);
+}
+
+// Adds an airport to the graph (vertex object)
+void Graph::addAirport(const std::string& code, const std::string& state, const std::string& city) {
+    internAirport(code, state, city);
 }
 
 // Adds a flight to the graph (edge object)
@@ -37,330 +124,225 @@ void Graph::addFlight(const std::string& origin, const std::string& dest, int di
     int destIndex = getAirportIndex(dest);
     if (originIndex == -1 || destIndex == -1) return;
 
-    // Create new edge, set variables, add to a vertex adjacencyList based on given origin
+    // Create new edge, set variables, add to the adjacency list of the origin
     Edge e;
     e.destIndex = destIndex;
     e.distance = distance;
     e.cost = cost;
-    vertices[originIndex].adjacencyList.push_back(e);
+    adjacency[originIndex].push_back(e);
+    degrees.addEdge(originIndex, destIndex);
+    invalidateViews();
+    if (!connectivityStale && !connectivity.addEdge(originIndex, destIndex)) connectivityStale = true;
 }
 
-// Attempts to find and return the index of the given airport code in the vertices vector. If not found, returns -1
-int Graph::getAirportIndex(const std::string& code) const {
-    for (int i = 0; i < vertices.size(); ++i) {
-        if (vertices[i].airportCode == code) return i;
+// Removes the first flight from origin to dest. Returns false if there is none
+bool Graph::removeFlight(const std::string& origin, const std::string& dest) {
+    int originIndex = getAirportIndex(origin);
+    int destIndex = getAirportIndex(dest);
+    if (originIndex == -1 || destIndex == -1) return false;
+
+    auto& flights = adjacency[originIndex];
+    auto it = std::find_if(flights.begin(), flights.end(), [&](const Edge& e) { return e.destIndex == destIndex; });
+    if (it == flights.end()) return false;
+    flights.erase(it);
+    degrees.removeEdge(originIndex, destIndex);
+    invalidateViews();
+    connectivityStale = true; // Removing a flight can split a component, which the index can't do in place
+    return true;
+}
+
+// Changes the cost of the first flight from origin to dest. Returns false if there is none
+bool Graph::setFlightCost(const std::string& origin, const std::string& dest, int cost) {
+    int originIndex = getAirportIndex(origin);
+    int destIndex = getAirportIndex(dest);
+    if (originIndex == -1 || destIndex == -1) return false;
+
+    for (auto& edge : adjacency[originIndex]) {
+        if (edge.destIndex == destIndex) {
+            edge.cost = cost;
+            invalidateViews();
+            return true;
+        }
     }
-    return -1; // Not found
+    return false;
+}
+
+// Attempts to find and return the index of the given airport code. If not found, returns -1
+int Graph::getAirportIndex(const std::string& code) const {
+    return airports.find(code);
 }
 
 // Prints graph for debugging
 void Graph::printGraph() const {
-    for (const auto& vertex : vertices) {
-        std::cout << "Airport: " << vertex.airportCode << ", State: " << vertex.state << std::endl;
-        for (const auto& edge : vertex.adjacencyList) {
-            std::cout << "  -> " << vertices[edge.destIndex].airportCode
+    for (int v = 0; v < airportCount(); ++v) {
+        std::cout << "Airport: " << airports.code(v) << ", State: " << airports.state(v) << std::endl;
+        for (const auto& edge : adjacency[v]) {
+            std::cout << "  -> " << airports.code(edge.destIndex)
                       << " (Dist: " << edge.distance << ", Cost: " << edge.cost << ")" << std::endl;
         }
     }
 }
 
-// Returns graph vertices
-const std::vector<Graph::Vertex>& Graph::getVertices() const {
-    return vertices;
+// Returns the number of airports
+int Graph::airportCount() const {
+    return airports.size();
 }
 
-// Calculates and prints the shortest path between the given origin and destination airports (dijkstra's algorithm)
-void Graph::shortestPath(const std::string& origin, const std::string& destination) const {
-    // Get source and destination airport index
-    int i_src = getAirportIndex(origin);
-    int i_dest = getAirportIndex(destination);
-    
-    // Index validation
-    if (i_src == -1 || i_dest == -1) {
-        throw std::string("Shortest path: incorrect vertices"); 
-    }
+// Returns the code of the given airport index
+std::string Graph::getAirportCode(int index) const {
+    return airports.code(index);
+}
 
-    // Initial distances
-    std::vector<int> distances(vertices.size(), std::numeric_limits<int>::max());
-    std::vector<bool> visited(vertices.size(), false);
-    std::vector<int> prev(vertices.size(), -1);
-    distances[i_src] = 0;
-    int cur = i_src;
-    int visited_count = 0;
-
-    // Visit all vertices
-    while (visited_count < vertices.size()) {
-        int i = cur;
-
-        for (const auto& edge : vertices[i].adjacencyList) {
-            int neighbor = edge.destIndex;
-            if (!visited[neighbor]) {
-                int alt = distances[i] + edge.distance;
-                if (alt < distances[neighbor]) {
-                    distances[neighbor] = alt;
-                    prev[neighbor] = i;
-                }
-            }
-        }
+// Returns the state of the given airport index
+std::string_view Graph::getState(int index) const {
+    return airports.state(index);
+}
 
-        // Find the next closest unvisited vertex
-        int minDist = std::numeric_limits<int>::max();
-        cur = -1;
-        for (int j = 0; j < vertices.size(); j++) {
-            if (!visited[j] && distances[j] < minDist) {
-                minDist = distances[j];
-                cur = j;
-            }
-        }
+// Returns the city of the given airport index (empty unless one was given to addAirport)
+std::string_view Graph::getCity(int index) const {
+    return airports.city(index);
+}
 
-        if (cur == -1) break; // No valid vertex, break loop
+// Returns the flights leaving the given airport index
+const std::vector<Graph::Edge>& Graph::getFlights(int index) const {
+    return adjacency[index];
+}
 
-        visited[cur] = true;
-        visited_count++;
-    }
+// Returns the airport metadata store
+const AirportMetadata& Graph::getMetadata() const {
+    return airports;
+}
 
-    // No path available
-    if (distances[i_dest] == std::numeric_limits<int>::max()) {
-        std::cout << "Shortest route from " << origin << " to " << destination << ": " << "N/A" << std::endl;
-        return;
-    }
+// Packs the adjacency lists into a read-only CSR snapshot for the query engines
+FrozenGraph Graph::freeze() const {
+    FrozenGraph frozen;
+    frozen.airports = airports;
 
-    // Retrace path
-    std::vector<int> path;
-    for (int at = i_dest; at != -1; at = prev[at]) {
-        path.insert(path.begin(), at);
+    // Count edges so every array is allocated exactly once
+    size_t edgeCount = 0;
+    for (const auto& flights : adjacency) {
+        edgeCount += flights.size();
     }
-    
-    // Calculate cost
-    int routeCost = 0;
-    for (size_t i = 0; i < path.size() - 1; ++i) {
-        int from = path[i];
-        int to = path[i + 1];
-        for (const auto& edge : vertices[from].adjacencyList) {
-            if (edge.destIndex == to) {
-                routeCost += edge.cost;
-                break;
-            }
+    std::vector<int> offsets, targets, distances, costs;
+    offsets.reserve(adjacency.size() + 1);
+    targets.reserve(edgeCount);
+    distances.reserve(edgeCount);
+    costs.reserve(edgeCount);
+
+    // Copy edges vertex by vertex, keeping adjacency order
+    offsets.push_back(0);
+    for (const auto& flights : adjacency) {
+        for (const auto& edge : flights) {
+            targets.push_back(edge.destIndex);
+            distances.push_back(edge.distance);
+            costs.push_back(edge.cost);
         }
+        offsets.push_back(static_cast<int>(targets.size()));
     }
-    
-    // Output shortest route
-    std::cout << "Shortest route from " << origin << " to " << destination << ": ";
-    for (size_t i = 0; i < path.size(); ++i) {
-        std::cout << vertices[path[i]].airportCode;
-        if (i != path.size() - 1) std::cout << " -> ";
+    frozen.edgeOffsets = std::move(offsets);
+    frozen.edgeTargets = std::move(targets);
+    frozen.edgeDistances = std::move(distances);
+    frozen.edgeCosts = std::move(costs);
+    frozen.buildReverseEdges();
+    frozen.buildStateIndex();
+
+    std::lock_guard<std::mutex> guard(connectivityLock.mutex);
+    if (connectivityStale) {
+        connectivity.build(frozen.vertexCount(), frozen.edgeOffsets.data(), frozen.edgeTargets.data());
+        connectivityStale = false;
     }
-    // Output distance and cost
-    std::cout << ". The length is " << distances[i_dest] << ".";
-    std::cout << " The cost is " << routeCost << "." << std::endl;
+    frozen.connectivity = std::make_shared<const ConnectivityIndex>(connectivity);
+    frozen.version = version;
+    return frozen;
 }
 
-// Calculates and prints all shortest paths between the given origin airport and all destination airports in a given state (dijkstra's algorithm)
-void Graph::shortestPathsToState(const std::string& origin, const std::string& state) const {
-    // Get source airport index
-    int src = getAirportIndex(origin);
-    
-    // Index validation
-    if (src == -1) {
-        std::cout << "Invalid origin airport." << std::endl;
-        return;
-    }
-    
-    // Initial distances
-    std::vector<int> distances(vertices.size(), std::numeric_limits<int>::max());
-    std::vector<bool> visited(vertices.size(), false);
-    std::vector<int> prev(vertices.size(), -1);
-    distances[src] = 0;
-    int cur = src;
-    int visited_count = 0;
-    
-    // Visit all vertices
-    while (visited_count < vertices.size()) {
-        int i = cur;
-
-        for (const auto& edge : vertices[i].adjacencyList) {
-            int neighbor = edge.destIndex;
-            if (!visited[neighbor]) {
-                int alt = distances[i] + edge.distance;
-                if (alt < distances[neighbor]) {
-                    distances[neighbor] = alt;
-                    prev[neighbor] = i;
-                }
-            }
-        }
-        
-        // Find the next closest unvisited vertex
-        int minDist = std::numeric_limits<int>::max();
-        cur = -1;
-        for (int j = 0; j < vertices.size(); j++) {
-            if (!visited[j] && distances[j] < minDist) {
-                minDist = distances[j];
-                cur = j;
-            }
-        }
+// Switches shortestPath to landmark-guided A* with the given number of landmarks (0 switches it off). The landmark
+// tables are rebuilt with every snapshot, so this suits graphs that are queried far more often than changed
+void Graph::useLandmarks(int count) {
+    landmarkCount = count;
+    invalidateViews();
+}
 
-        if (cur == -1) break; // No valid vertex, break loop
+// Switches shortestPath and shortestPathsToState to lookups in precomputed all-pairs tables (one per metric) on
+// graphs of up to AllPairsTable::SNAPSHOT_MAX_VERTICES airports; larger graphs keep searching. The tables are
+// rebuilt with every snapshot in O(V^2) memory, so this suits small networks queried far more often than changed
+void Graph::useAllPairs(bool on) {
+    allPairsEnabled = on;
+    invalidateViews();
+}
 
-        visited[cur] = true;
-        visited_count++;
-    }
-    
-    // Print routes
-    std::cout << "Shortest path from " << origin << " to " << state << " state airports are:" << endl;
-    bool pathFound = false;
-    for (int dst = 0; dst < vertices.size(); ++dst) {
-        if (distances[dst] == std::numeric_limits<int>::max()) continue;
-
-        if (vertices[dst].state != state) continue;
-
-        pathFound = true;
-        std::vector<int> path;
-        for (int at = dst; at != -1; at = prev[at]) {
-            path.insert(path.begin(), at);
+// Returns the pool that builds the indexes attached to snapshots. It starts on first use and is shared by every
+// graph, so re-freezing a small graph after each change doesn't spawn and join a thread per core
+static ThreadPool& snapshotPool() {
+    static ThreadPool pool;
+    return pool;
+}
+
+// Returns the cached snapshot, rebuilding it first if the graph changed since it was taken. Concurrent callers
+// wait for a single rebuild
+const FrozenGraph& Graph::snapshot() const {
+    std::lock_guard<std::mutex> guard(snapshotLock.mutex);
+    if (snapshotStale) {
+        frozenSnapshot = freeze();
+        if (landmarkCount > 0) {
+            auto index = std::make_shared<LandmarkIndex>();
+            index->build(frozenSnapshot, snapshotPool(), landmarkCount);
+            frozenSnapshot.attachLandmarks(index);
         }
-        
-        // Calculate route cost
-        int totalCost = 0;
-        for (size_t i = 0; i < path.size() - 1; ++i) {
-            int from = path[i];
-            int to = path[i + 1];
-            for (const auto& edge : vertices[from].adjacencyList) {
-                if (edge.destIndex == to) {
-                    totalCost += edge.cost;
-                    break;
-                }
+        if (allPairsEnabled && frozenSnapshot.vertexCount() <= AllPairsTable::SNAPSHOT_MAX_VERTICES) {
+            for (Metric metric : {Metric::Distance, Metric::Cost}) {
+                auto table = std::make_shared<AllPairsTable>();
+                table->build(frozenSnapshot, snapshotPool(), metric);
+                frozenSnapshot.attachAllPairs(table);
             }
         }
-        
-        // Print route
-        for (size_t j = 0; j < path.size(); ++j) {
-            std::cout << vertices[path[j]].airportCode;
-            if (j != path.size() - 1) std::cout << " -> ";
-        }
-        // Print distance and cost of route
-        std::cout << " | Length = " << distances[dst] << ", Cost = " << totalCost << std::endl;
-    }
-    
-    // No paths found
-    if (!pathFound) {
-        std::cout << "N/A" << std::endl;
+        frozenSnapshot.attachCache(queryCache);
+        snapshotStale = false;
     }
+    return frozenSnapshot;
+}
+
+// Caches the results of shortestPath, shortestPathWithStops and shortestPathsToState within roughly
+// memoryBudget bytes. Adding airports or flights bumps the graph version, which invalidates every cached result
+void Graph::enableQueryCache(size_t memoryBudget) {
+    queryCache = std::make_shared<QueryCache>(memoryBudget);
+    if (!snapshotStale) frozenSnapshot.attachCache(queryCache);
+}
+
+// Returns the query cache (for its hit/miss/eviction counters), or nullptr if caching is off
+std::shared_ptr<QueryCache> Graph::getQueryCache() const {
+    return queryCache;
+}
+
+// Returns the graph's current version, which changes whenever an airport or flight is added
+uint64_t Graph::getVersion() const {
+    return version;
+}
+
+// Calculates and prints the shortest path between the given origin and destination airports (dijkstra's algorithm)
+void Graph::shortestPath(const std::string& origin, const std::string& destination) const {
+    snapshot().shortestPath(origin, destination);
+}
+
+// Calculates and prints all shortest paths between the given origin airport and all destination airports in a given state (dijkstra's algorithm)
+void Graph::shortestPathsToState(const std::string& origin, const std::string& state) const {
+    snapshot().shortestPathsToState(origin, state);
 }
 
 // Calculates and prints the shortest path between the given origin and destination airport with a specified amount of stops
 void Graph::shortestPathWithStops(const std::string& origin, const std::string& destination, int stops) const {
-    // Get source and destination airport index
-    int src = getAirportIndex(origin);
-    int dst = getAirportIndex(destination);
-    // Index validation
-    if (src == -1 || dst == -1) {
-        std::cout << "Invalid airport codes." << std::endl;
-        return;
-    }
-    
-    // BFS node structure
-    struct Node {
-        int index;
-        int distance;
-        int cost;
-        int stops;
-        std::vector<int> path;
-    };
-    // Create and prepare queue, path, cost
-    std::vector<Node> queue;
-    queue.push_back({src, 0, 0, 0, {src}});
-    int minDistance = std::numeric_limits<int>::max();
-    std::vector<int> Path;
-    int Cost = 0;
-    
-    // Populate path (BFS Traversal)
-    while (!queue.empty()) {
-        // Dequeue front
-        Node node = queue.front();
-        queue.erase(queue.begin());
-        
-        // Destination reached with stops requirement
-        if (node.index == dst && node.stops == stops+1) { // stops+1 is a really hacky bandage for my awful logic but it functions
-            if (node.distance < minDistance) {
-                minDistance = node.distance;
-                Path = node.path;
-                Cost = node.cost;
-            }
-            continue; // path found
-        }
-        
-        if (node.stops >= stops+1) continue;
-        
-        // Traverse adjacent
-        for (const auto& edge : vertices[node.index].adjacencyList) {
-            std::vector<int> newPath = node.path;
-            newPath.push_back(edge.destIndex);
-            queue.push_back({
-                edge.destIndex, 
-                node.distance + edge.distance, 
-                node.cost + edge.cost, 
-                node.stops + 1, 
-                newPath
-                
-            });
-        }
-    }
+    snapshot().shortestPathWithStops(origin, destination, stops);
+}
 
-    // Print results
-    std::cout << "Shortest path from " << origin << " to " << destination << " with " << stops << " stops: ";
-    
-    // No path found
-    if (Path.empty()) {
-        std::cout << "N/A" << std::endl;
-        return;
-    }
-    
-    // Path found; print path
-    for (size_t i = 0; i < Path.size(); ++i) {
-        std::cout << vertices[Path[i]].airportCode;
-        if (i != Path.size() - 1) std::cout << " -> ";
-    }
-    std::cout << ". The length is " << minDistance << ". The cost is " << Cost << std::endl;
+// Calculates and prints the k shortest loopless routes between the given origin and destination airports
+void Graph::kShortestPaths(const std::string& origin, const std::string& destination, int k) const {
+    snapshot().kShortestPaths(origin, destination, k);
 }
 
 // Gathers and prints total direct flight connections for each airport, descending order
 void Graph::printFlightConnections() const {
-    std::vector<int> inboundCount(vertices.size(), 0); // Inbound connections
-    std::vector<std::pair<std::string, int>> connectionData; // Airport codes & their connections
-    
-    // Calculate inbound connections
-    for (int i = 0; i < vertices.size(); ++i) {
-        for (int j = 0; j < vertices[i].adjacencyList.size(); ++j) {
-            int dest = vertices[i].adjacencyList[j].destIndex;
-            if (dest >= 0 && dest < vertices.size()) {
-                inboundCount[dest]++;
-            }
-        }
-    }
-    
-    // Calculate outbound connections, add to inbound for total
-    for (int i = 0; i < vertices.size(); ++i) {
-        int outbound = vertices[i].adjacencyList.size();
-        int inbound = inboundCount[i];
-        int total = outbound + inbound;
-        connectionData.push_back({vertices[i].airportCode, total});
-    }
+    std::vector<std::pair<std::string, int>> connectionData = topHubs(adjacency.size()); // Airport codes & their connections
 
-    // Sort descending
-    for (int i = 0; i < connectionData.size() - 1; ++i) {
-        int maxIdx = i;
-        for (int j = i + 1; j < connectionData.size(); ++j) {
-            if (connectionData[j].second > connectionData[maxIdx].second) {
-                maxIdx = j;
-            }
-        }
-        if (maxIdx != i) {
-            std::pair<std::string, int> temp = connectionData[i];
-            connectionData[i] = connectionData[maxIdx];
-            connectionData[maxIdx] = temp;
-        }
-    }
-    
     // Print each airport and their total connections
     std::cout << "Airport | Connections" << std::endl;
     std::cout << "---------------------" << std::endl;
@@ -369,159 +351,75 @@ void Graph::printFlightConnections() const {
     }
 }
 
+// Returns the k airports with the most direct flights (inbound + outbound) and their counts, busiest first.
+// Reads the incrementally maintained ranking, so it costs O(k log k) however large the graph is
+std::vector<std::pair<std::string, int>> Graph::topHubs(size_t k) const {
+    std::vector<std::pair<std::string, int>> hubs;
+    for (int v : degrees.top(k)) {
+        hubs.push_back({airports.code(v), degrees.degree(v)});
+    }
+    return hubs;
+}
+
+// Returns the per-airport flight counters
+const DegreeIndex& Graph::degreeIndex() const {
+    return degrees;
+}
+
 // Undirected Graph methods
-// Constructor
+// Constructor. Every flight becomes an undirected edge, and parallel edges between two airports merge into one
+// with the minimum cost. Each airport's neighbours are gathered from the outbound and inbound CSR arrays of the
+// snapshot, so the whole view is built in O(V + E) without searching for reverse edges.
 Graph Graph::createUndirectedGraph() const {
+    const FrozenGraph& g = snapshot();
+    int n = g.vertexCount();
     Graph undirectedGraph;
 
-    // Copy vertexes (airports) to new graph
-    for (const auto& vertex : vertices) {
-        undirectedGraph.addAirport(vertex.airportCode, vertex.state);
-    }
-    
-    // Iterate through edges (flights)
-    for (int u = 0; u < vertices.size(); ++u) {
-        for (const auto& edge : vertices[u].adjacencyList) {
-            int v = edge.destIndex;
-            
-            // Look for reverse edge
-            int reverseCost = -1;
-            for (const auto& revEdge : vertices[v].adjacencyList) {
-                if (revEdge.destIndex == u) {
-                    reverseCost = revEdge.cost;
-                    break;
-                }
-            }
-
-            if (u < v) { // Avoid duplicates
-                // Use smaller cost as undirected edge, otherwise just use edge.cost
-                int minCost = (reverseCost != -1) ? std::min(edge.cost, reverseCost) : edge.cost;
-                undirectedGraph.addFlight(vertices[u].airportCode, vertices[v].airportCode, 0, minCost);
-                undirectedGraph.addFlight(vertices[v].airportCode, vertices[u].airportCode, 0, minCost);
+    // Copy the airports to new graph; the compact store copies as a handful of flat arrays
+    undirectedGraph.airports = airports;
+    undirectedGraph.adjacency.resize(n);
+
+    // Neighbours of each airport in order of first appearance, keeping the cheapest flight either way
+    std::vector<int> slot(n, -1); // Position of a neighbour in the current adjacency list
+    for (int u = 0; u < n; ++u) {
+        std::vector<Edge>& list = undirectedGraph.adjacency[u];
+        list.reserve((g.edgeEnd(u) - g.edgeBegin(u)) + (g.reverseEnd(u) - g.reverseBegin(u)));
+        auto connect = [&](int v, int cost) {
+            if (v == u) return;
+            if (slot[v] == -1) {
+                slot[v] = static_cast<int>(list.size());
+                list.push_back({v, 0, cost});
+            } else {
+                list[slot[v]].cost = std::min(list[slot[v]].cost, cost);
             }
-        }
+        };
+        for (int e = g.edgeBegin(u); e < g.edgeEnd(u); ++e) connect(g.edgeTarget(e), g.edgeCost(e));
+        for (int e = g.reverseBegin(u); e < g.reverseEnd(u); ++e) connect(g.reverseSource(e), g.reverseCost(e));
+        for (const auto& edge : list) slot[edge.destIndex] = -1;
     }
 
+    // Every undirected edge is stored once in each direction, so inbound and outbound counts match
+    std::vector<int> counts(n);
+    for (int u = 0; u < n; ++u) counts[u] = static_cast<int>(undirectedGraph.adjacency[u].size());
+    undirectedGraph.degrees.build(counts, counts);
     return undirectedGraph;
 }
 
-// Creates an MST using Prim's algorithm on an undirected graph.
-// Note: The given airport data always creates a disconnected graph, meaning this will never actually work.
-void Graph::primMST() const {
-    // Empty graphs can't make MSTs
-    if (vertices.empty()) {
-        std::cout << "Graph is empty. MST cannot be formed." << std::endl;
-        return;
+// Returns the undirected view of the graph, building it on first use and reusing it until the graph changes
+const Graph& Graph::undirectedView() const {
+    std::lock_guard<std::mutex> guard(undirectedLock.mutex);
+    if (!undirectedCache) {
+        undirectedCache = std::make_shared<const Graph>(createUndirectedGraph());
     }
+    return *undirectedCache;
+}
 
-    int n = vertices.size();
-    std::vector<bool> inMST(n, false); // Track presence in MST
-    std::vector<int> parent(n, -1); // Store parents of each vertex
-    std::vector<int> key(n, std::numeric_limits<int>::max()); // Minimum cost for each vertex
-    key[0] = 0;
-    
-    // Construct MST
-    for (int count = 0; count < n - 1; ++count) {
-        int u = -1;
-        int minKey = std::numeric_limits<int>::max();
-        for (int v = 0; v < n; ++v) { // Prioritize smaller keys
-            if (!inMST[v] && key[v] < minKey) {
-                minKey = key[v];
-                u = v;
-            }
-        }
-
-        if (u == -1) { // Graph is disconnected, can't build MST
-            std::cout << "Disconnected graph; primMST cannot be built" << std::endl;
-            return;
-        }
-
-        inMST[u] = true; // Mark selected vertex as being in MST
-        
-        // Update key and parent for adj.
-        for (const auto& edge : vertices[u].adjacencyList) {
-            int v = edge.destIndex;
-            if (!inMST[v] && edge.cost < key[v]) {
-                key[v] = edge.cost;
-                parent[v] = u;
-            }
-        }
-    }
-    
-    // Print MST
-    int totalCost = 0;
-    std::cout << "Minimal Spanning Tree (Prim): " << std::endl;
-    for (int i = 1; i < n; ++i) {
-        if (parent[i] != -1) {
-            std::cout << vertices[parent[i]].airportCode << " - " << vertices[i].airportCode << " | Weight: " << key[i] << std::endl;
-            totalCost += key[i];
-        }
-    }
-    std::cout << "Total cost of MST: " << totalCost << std::endl;
+// Creates an MST using Prim's algorithm on an undirected graph (a spanning forest when it is disconnected)
+void Graph::primMST() const {
+    snapshot().primMST();
 }
 
 // Creates an MST using Kruskal's algorithm on an undirected graph.
 void Graph::kruskalMST() const {
-    struct EdgeInfo { // Helper structure
-        int u;
-        int v;
-        int cost;
-    };
-    
-    // Get all edges
-    std::vector<EdgeInfo> allEdges;
-    for (int u = 0; u < vertices.size(); ++u) {
-        for (const auto& edge : vertices[u].adjacencyList) {
-            if (u < edge.destIndex) {
-                allEdges.push_back({u, edge.destIndex, edge.cost});
-            }
-        }
-    }
-
-    // Sort edges by cost
-    for (int i = 0; i < allEdges.size() - 1; ++i) {
-        int minIdx = i;
-        for (int j = i + 1; j < allEdges.size(); ++j) {
-            if (allEdges[j].cost < allEdges[minIdx].cost) {
-                minIdx = j;
-            }
-        }
-        if (minIdx != i) {
-            EdgeInfo temp = allEdges[i];
-            allEdges[i] = allEdges[minIdx];
-            allEdges[minIdx] = temp;
-        }
-    }
-    
-    // Union-find
-    std::vector<int> parent(vertices.size());
-    for (int i = 0; i < vertices.size(); ++i) {
-        parent[i] = i;
-    }
-    
-    // Find set root (helper)
-    auto find = [&](int x) {
-        while (x != parent[x]) x = parent[x];
-        return x;
-    };
-    
-    // Unite sets (helper)
-    auto unite = [&](int x, int y) {
-        int rootX = find(x);
-        int rootY = find(y);
-        if (rootX == rootY) return false;
-        parent[rootY] = rootX;
-        return true;
-    };
-    
-    // Print MST
-    int totalCost = 0;
-    std::cout << "Minimal Spanning Tree (Kruskal): " << std::endl;
-    for (const auto& edge : allEdges) {
-        if (unite(edge.u, edge.v)) {
-            std::cout << vertices[edge.u].airportCode << " - " << vertices[edge.v].airportCode << " | Weight: " << edge.cost << std::endl;
-            totalCost += edge.cost;
-        }
-    }
-    std::cout << "Total cost of MST: " << totalCost << std::endl;
+    snapshot().kruskalMST();
 }
\ No newline at end of file
@@ -2,10 +2,16 @@
 #define GRAPH_H
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <limits>
+#include <memory>
+#include <mutex>
+#include "frozengraph.h"
+#include "degrees.h"
+#include "metadata.h"
 
-class Queue {
+class Queue { // FIFO ring buffer; push and pop never shift the stored nodes
 private:
     struct Node {
         int index;
@@ -15,6 +21,8 @@ private:
         std::vector<int> path;
     };
     std::vector<Node> data;
+    size_t head = 0;
+    size_t count = 0;
 public:
     void push(int index, int distance, int cost, int stops, const std::vector<int>& path);
     Node pop();
@@ -29,30 +37,106 @@ private:
         int cost;
     };
 
-    struct Vertex { // Represents airports
-        std::string airportCode;
-        std::string city;
-        std::string state;
-        std::vector<Edge> adjacencyList;
+    // Airports (vertices): codes, states and cities in a compact interned store that also resolves codes to
+    // indices, and separately the flights leaving each airport
+    AirportMetadata airports;
+    std::vector<std::vector<Edge>> adjacency;
+
+    struct ViewLock { // Mutex guarding lazily built state; a copied graph gets a fresh one
+        std::mutex mutex;
+        ViewLock() = default;
+        ViewLock(const ViewLock&) {}
+        ViewLock& operator=(const ViewLock&) { return *this; }
     };
-    
-    // Vector containing graph vertex objects
-    std::vector<Vertex> vertices;
+
+    // Lazily rebuilt CSR snapshot that the query methods run on. Const methods may be called from several
+    // threads at once (the locks below serialize the lazy rebuilds and nest as undirectedLock, snapshotLock,
+    // connectivityLock), but not concurrently with any method that changes the graph
+    mutable FrozenGraph frozenSnapshot;
+    mutable bool snapshotStale = true;
+    int landmarkCount = 0; // Landmarks to build with each snapshot, 0 for plain Dijkstra
+    bool allPairsEnabled = false; // Build all-pairs tables with each snapshot
+    mutable ViewLock snapshotLock;
+    mutable ViewLock connectivityLock;
+    mutable ViewLock undirectedLock;
+
+    // Component reachability, updated in place as airports and flights are added. Flights that merge
+    // components mark it stale and it is rebuilt with the next snapshot
+    mutable ConnectivityIndex connectivity;
+    mutable bool connectivityStale = true;
+
+    // Inbound/outbound flight counts and the airport ranking by total connections
+    DegreeIndex degrees;
+
+    // Lazily built undirected view, dropped whenever the graph changes
+    mutable std::shared_ptr<const Graph> undirectedCache;
+
+    // Bumped by every change; cached query results computed on an older version are discarded
+    uint64_t version = 0;
+    std::shared_ptr<QueryCache> queryCache;
+
+    int internAirport(std::string_view code, std::string_view state, std::string_view city = {});
+    void invalidateViews();
+    template <typename Record>
+    void addFlightBatch(const std::vector<Record>& flights);
+    const FrozenGraph& snapshot() const;
 
 public: // See implementation file for details
+    struct FlightRecord { // One row of the route feed, used for bulk loading
+        std::string origin;
+        std::string originState;
+        std::string dest;
+        std::string destState;
+        int distance;
+        int cost;
+        std::string originCity; // Optional
+        std::string destCity;
+    };
+
+    struct FlightView { // Same as FlightRecord, but viewing text owned by the caller (e.g. a mapped file)
+        std::string_view origin;
+        std::string_view originState;
+        std::string_view dest;
+        std::string_view destState;
+        int distance;
+        int cost;
+        std::string_view originCity;
+        std::string_view destCity;
+    };
+
     // Graph methods
-    void addAirport(const std::string& code, const std::string& state);
+    void reserve(size_t airportCount);
+    void addFlights(const std::vector<FlightRecord>& flights);
+    void addFlights(const std::vector<FlightView>& flights);
+    void addAirport(const std::string& code, const std::string& state, const std::string& city = "");
     void addFlight(const std::string& origin, const std::string& dest, int distance, int cost);
+    bool removeFlight(const std::string& origin, const std::string& dest);
+    bool setFlightCost(const std::string& origin, const std::string& dest, int cost);
     int getAirportIndex(const std::string& code) const;
     void printGraph() const;
-    const std::vector<Vertex>& getVertices() const;
+    int airportCount() const;
+    std::string getAirportCode(int index) const;
+    std::string_view getState(int index) const;
+    std::string_view getCity(int index) const;
+    const std::vector<Edge>& getFlights(int index) const;
+    const AirportMetadata& getMetadata() const;
+    FrozenGraph freeze() const;
+    void useLandmarks(int count);
+    void useAllPairs(bool on);
+    void enableQueryCache(size_t memoryBudget = 64 << 20);
+    std::shared_ptr<QueryCache> getQueryCache() const;
+    uint64_t getVersion() const;
     void shortestPath(const std::string& origin, const std::string& destination) const;
     void shortestPathsToState(const std::string& origin, const std::string& state) const;
     void shortestPathWithStops(const std::string& origin, const std::string& destination, int maxStops) const;
+    void kShortestPaths(const std::string& origin, const std::string& destination, int k) const;
     void printFlightConnections() const;
+    std::vector<std::pair<std::string, int>> topHubs(size_t k) const;
+    const DegreeIndex& degreeIndex() const;
     
     // Undirected Graph methods
     Graph createUndirectedGraph() const;
+    const Graph& undirectedView() const;
     void primMST() const;
     void kruskalMST() const;
 };
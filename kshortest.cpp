@@ -0,0 +1,348 @@
+#include "kshortest.h"
+#include "frozengraph.h"
+#include "threadpool.h"
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <mutex>
+#include <set>
+
+namespace {
+
+const double TREE_MARGIN = 1.25; // Tree radius, as a multiple of the shortest route, before the first bound is known
+
+// Route being built or accepted, with the metric key, distance and cost accumulated up to each airport on it
+struct Candidate {
+    std::vector<int> path;
+    std::vector<int> keys;
+    std::vector<int> distances;
+    std::vector<int> costs;
+    int deviation = 0; // Index of the spur airport it left its parent route at; earlier spurs were already searched
+
+    // Orders by total key, then by path, so equal routes found from different spurs collapse into one
+    bool operator<(const Candidate& other) const {
+        if (keys.back() != other.keys.back()) return keys.back() < other.keys.back();
+        return path < other.path;
+    }
+};
+
+// Shortest-path tree into the destination, grown on demand by a backward Dijkstra that can be resumed. Settled
+// airports know their exact remaining key and next hop; every other airport is at least as far as the smallest
+// queued key, so the tree gives spur searches a consistent A* heuristic at any size
+class ReverseTree {
+private:
+    const FrozenGraph& g;
+    SearchWorkspace& ws;
+    Metric metric;
+
+    // Settles the queued airport nearest the destination
+    void settleNext() {
+        int u = ws.popMin();
+        int key = ws.key(u), distance = ws.distance(u), cost = ws.cost(u);
+        for (int e = g.reverseBegin(u); e < g.reverseEnd(u); ++e) {
+            int weight = (metric == Metric::Distance) ? g.reverseDistance(e) : g.reverseCost(e);
+            ws.improve(g.reverseSource(e), key + weight, distance + g.reverseDistance(e), cost + g.reverseCost(e), u);
+        }
+    }
+
+public:
+    ReverseTree(const FrozenGraph& g, int destination, Metric metric, SearchWorkspace& ws) : g(g), ws(ws), metric(metric) {
+        ws.begin(g.vertexCount());
+        ws.improve(destination, 0, 0, 0, -1);
+    }
+
+    // Grows the tree until v is settled or nothing more can reach the destination
+    void settle(int v) {
+        while (!ws.settled(v) && !ws.empty()) settleNext();
+    }
+
+    // Grows the tree until it holds every airport within radius of the destination
+    void growTo(long long radius) {
+        while (!ws.empty() && ws.minKey() <= radius) settleNext();
+    }
+
+    bool settled(int v) const { return ws.settled(v); }
+    int parent(int v) const { return ws.parent(v); }
+    int key(int v) const { return ws.key(v); }
+    int distance(int v) const { return ws.distance(v); }
+    int cost(int v) const { return ws.cost(v); }
+
+    // Returns a lower bound on the remaining key from v (exact once settled), or -1 if v cannot reach the destination
+    int lowerBound(int v) const {
+        if (ws.settled(v)) return ws.key(v);
+        return ws.empty() ? -1 : ws.minKey();
+    }
+};
+
+// Per-thread masks for spur searches. Blocked airports (the root of the route before the spur) and the memoized
+// answer to "does the tree route from v avoid every blocked airport" are epoch-stamped, so a spur search resets
+// them in O(1)
+struct SpurMasks {
+    std::vector<uint32_t> blockedStamp;
+    std::vector<uint32_t> knownStamp;
+    std::vector<char> clean;
+    std::vector<int> walk;
+    uint32_t epoch = 0;
+
+    // Starts a new spur search
+    void begin(int vertexCount) {
+        if (blockedStamp.size() < vertexCount) {
+            blockedStamp.resize(vertexCount, 0);
+            knownStamp.resize(vertexCount, 0);
+            clean.resize(vertexCount);
+        }
+        if (++epoch == 0) { // Stamp counter wrapped; old stamps could look current again
+            std::fill(blockedStamp.begin(), blockedStamp.end(), 0);
+            std::fill(knownStamp.begin(), knownStamp.end(), 0);
+            epoch = 1;
+        }
+    }
+
+    void block(int v) { blockedStamp[v] = epoch; }
+    bool blocked(int v) const { return blockedStamp[v] == epoch; }
+
+    // Returns whether the tree route from v to the destination avoids the blocked airports and the spur airport
+    bool treeRouteClear(const ReverseTree& tree, int v, int spur, int destination) {
+        walk.clear();
+        bool clear;
+        for (;;) {
+            if (v == destination) {
+                clear = true;
+                break;
+            }
+            if (knownStamp[v] == epoch) {
+                clear = clean[v];
+                break;
+            }
+            if (blocked(v) || v == spur || !tree.settled(v)) {
+                clear = false;
+                break;
+            }
+            walk.push_back(v);
+            v = tree.parent(v);
+        }
+        for (int w : walk) {
+            knownStamp[w] = epoch;
+            clean[w] = clear;
+        }
+        return clear;
+    }
+
+    static SpurMasks& local() {
+        thread_local SpurMasks masks;
+        return masks;
+    }
+};
+
+// Largest key a spur route can have and still make the final list. Every candidate already queued and every spur
+// of the round has a slot holding the smallest key known for it: the candidate's key, or the key of any route the
+// spur is known to have; the bound is the wanted-th smallest slot. Spur searches running in parallel lower their
+// slots as they finish and give up once their queue's smallest key is beyond the bound. Only strictly larger keys
+// are cut, so the routes returned don't depend on the order the spurs finish in
+class KeyBound {
+private:
+    std::mutex lock;
+    std::vector<int> slots;
+    std::vector<int> scratch;
+    size_t wanted;
+    std::atomic<int> limit{std::numeric_limits<int>::max()};
+
+public:
+    KeyBound(size_t wanted, size_t slotCount) : slots(slotCount, std::numeric_limits<int>::max()), wanted(wanted) {}
+
+    // Records that the candidate or spur in the given slot has a route with the given key
+    void offer(size_t slot, int key) {
+        std::lock_guard<std::mutex> guard(lock);
+        if (key >= slots[slot]) return;
+        slots[slot] = key;
+        if (slots.size() < wanted) return;
+        scratch = slots;
+        std::nth_element(scratch.begin(), scratch.begin() + (wanted - 1), scratch.end());
+        limit.store(scratch[wanted - 1], std::memory_order_relaxed);
+    }
+
+    int get() const { return limit.load(std::memory_order_relaxed); }
+};
+
+// Returns the smallest key of a route that leaves parent.path[spurIndex] by one flight and then follows the tree,
+// avoiding the same airports and flights as the spur search, or -1 if there is none. It is what a spur search
+// finds when the deviation is a single flight, and an upper bound on its result otherwise
+int sidetrackKey(const FrozenGraph& g, const ReverseTree& tree, int destination, const Candidate& parent, int spurIndex,
+                 const std::vector<int>& blockedNext, Metric metric) {
+    int spur = parent.path[spurIndex];
+    SpurMasks& masks = SpurMasks::local();
+    masks.begin(g.vertexCount());
+    for (int i = 0; i < spurIndex; ++i) masks.block(parent.path[i]);
+
+    long long best = -1;
+    for (int e = g.edgeBegin(spur); e < g.edgeEnd(spur); ++e) {
+        int v = g.edgeTarget(e);
+        if (masks.blocked(v) || v == spur || std::find(blockedNext.begin(), blockedNext.end(), v) != blockedNext.end()) continue;
+        if (!masks.treeRouteClear(tree, v, spur, destination)) continue;
+        long long key = (long long)parent.keys[spurIndex] + ((metric == Metric::Distance) ? g.edgeDistance(e) : g.edgeCost(e)) + tree.key(v);
+        if (best == -1 || key < best) best = key;
+    }
+    return (best > std::numeric_limits<int>::max()) ? -1 : static_cast<int>(best);
+}
+
+// Finds the best route from parent.path[spurIndex] to destination that avoids the airports before the spur and
+// the flights in blockedNext leaving the spur, as an A* search guided by the tree's distances to destination.
+// Every airport the search settles is checked for a clear tree route; the first one found completes the optimal
+// spur, since the heuristic is exact along it. Writes parent's root plus the spur route into result, and returns
+// false if there is no such route or it would cost more than the bound
+bool spurRoute(const FrozenGraph& g, const ReverseTree& tree, int destination, const Candidate& parent, int spurIndex,
+               const std::vector<int>& blockedNext, Metric metric, const KeyBound& bound, Candidate& result) {
+    int spur = parent.path[spurIndex];
+    SearchWorkspace& ws = SearchWorkspace::local(0);
+    SpurMasks& masks = SpurMasks::local();
+    ws.begin(g.vertexCount());
+    masks.begin(g.vertexCount());
+    for (int i = 0; i < spurIndex; ++i) masks.block(parent.path[i]);
+    auto nextBlocked = [&](int v) { return std::find(blockedNext.begin(), blockedNext.end(), v) != blockedNext.end(); };
+
+    int baseKey = parent.keys[spurIndex], baseDistance = parent.distances[spurIndex], baseCost = parent.costs[spurIndex];
+    int found = -1;
+    auto reachedKey = [&](int v) { return (metric == Metric::Distance) ? ws.distance(v) : ws.cost(v); };
+    ws.improve(spur, tree.lowerBound(spur), 0, 0, -1);
+    while (!ws.empty() && baseKey + (long long)ws.minKey() <= bound.get()) {
+        int u = ws.popMin();
+        if (u == spur) {
+            int next = tree.settled(spur) ? tree.parent(spur) : -1;
+            if (next != -1 && !nextBlocked(next) && masks.treeRouteClear(tree, next, spur, destination)) {
+                found = u;
+                break;
+            }
+        } else if (masks.treeRouteClear(tree, u, spur, destination)) {
+            found = u;
+            break;
+        }
+
+        int key = reachedKey(u), distance = ws.distance(u), cost = ws.cost(u);
+        for (int e = g.edgeBegin(u); e < g.edgeEnd(u); ++e) {
+            int v = g.edgeTarget(e);
+            int remaining = tree.lowerBound(v);
+            if (remaining < 0 || masks.blocked(v) || (u == spur && nextBlocked(v))) continue;
+            int weight = (metric == Metric::Distance) ? g.edgeDistance(e) : g.edgeCost(e);
+            ws.improve(v, key + weight + remaining, distance + g.edgeDistance(e), cost + g.edgeCost(e), u);
+        }
+    }
+    if (found == -1) return false;
+
+    // Root of the parent route, then the searched part back to front, then the tree route
+    result.path.assign(parent.path.begin(), parent.path.begin() + spurIndex);
+    result.keys.assign(parent.keys.begin(), parent.keys.begin() + spurIndex);
+    result.distances.assign(parent.distances.begin(), parent.distances.begin() + spurIndex);
+    result.costs.assign(parent.costs.begin(), parent.costs.begin() + spurIndex);
+    size_t searched = result.path.size();
+    for (int at = found; at != -1; at = ws.parent(at)) {
+        result.path.push_back(at);
+        result.keys.push_back(baseKey + reachedKey(at));
+        result.distances.push_back(baseDistance + ws.distance(at));
+        result.costs.push_back(baseCost + ws.cost(at));
+    }
+    std::reverse(result.path.begin() + searched, result.path.end());
+    std::reverse(result.keys.begin() + searched, result.keys.end());
+    std::reverse(result.distances.begin() + searched, result.distances.end());
+    std::reverse(result.costs.begin() + searched, result.costs.end());
+    int foundKey = result.keys.back(), foundDistance = result.distances.back(), foundCost = result.costs.back();
+    for (int at = found; at != destination;) {
+        at = tree.parent(at);
+        result.path.push_back(at);
+        result.keys.push_back(foundKey + tree.key(found) - tree.key(at));
+        result.distances.push_back(foundDistance + tree.distance(found) - tree.distance(at));
+        result.costs.push_back(foundCost + tree.cost(found) - tree.cost(at));
+    }
+    result.deviation = spurIndex;
+    return true;
+}
+
+} // namespace
+
+// Yen's algorithm with Lawler's refinement: each accepted route only spurs from its deviation airport onwards
+std::vector<RouteResult> kShortestRoutes(const FrozenGraph& g, int origin, int destination, int k, Metric metric, ThreadPool* pool) {
+    std::vector<RouteResult> routes;
+    if (k <= 0) return routes;
+
+    // Shortest-path tree into destination, grown at first only until it reaches the origin
+    ReverseTree tree(g, destination, metric, SearchWorkspace::local(1));
+    tree.settle(origin);
+    if (!tree.settled(origin)) return routes;
+
+    Candidate first;
+    for (int at = origin; at != -1; at = tree.parent(at)) {
+        first.path.push_back(at);
+        first.keys.push_back(tree.key(origin) - tree.key(at));
+        first.distances.push_back(tree.distance(origin) - tree.distance(at));
+        first.costs.push_back(tree.cost(origin) - tree.cost(at));
+    }
+
+    std::vector<Candidate> accepted{first};
+    std::set<Candidate> candidates;
+    std::vector<Candidate> spurs;
+    std::vector<char> spurFound;
+    std::vector<std::vector<int>> blockedNext;
+    while (static_cast<int>(accepted.size()) < k) {
+        const Candidate& last = accepted.back();
+        int spurCount = static_cast<int>(last.path.size()) - 1 - last.deviation;
+
+        // Flights to mask at each spur: the next hop of every accepted route sharing the root up to the spur
+        blockedNext.assign(std::max(spurCount, 0), std::vector<int>());
+        for (int s = 0; s < spurCount; ++s) {
+            int spurIndex = last.deviation + s;
+            for (const Candidate& route : accepted) {
+                if (route.path.size() > spurIndex + 1 &&
+                    std::equal(last.path.begin(), last.path.begin() + spurIndex + 1, route.path.begin())) {
+                    blockedNext[s].push_back(route.path[spurIndex + 1]);
+                }
+            }
+        }
+
+        // Only the best (k - accepted) candidates can still be accepted
+        size_t wanted = k - accepted.size();
+        KeyBound bound(wanted, candidates.size() + std::max(spurCount, 0));
+        size_t slot = 0;
+        for (const Candidate& candidate : candidates) bound.offer(slot++, candidate.keys.back());
+
+        // A tree covering every airport within the bound of the destination guides spurs as well as the full
+        // tree would; until there is a bound, cover a margin beyond the shortest route
+        long long radius = (bound.get() < std::numeric_limits<int>::max()) ? bound.get() : tree.key(origin) * TREE_MARGIN;
+        tree.growTo(radius);
+
+        // One-flight deviations are cheap to find and bound what each spur search has to look at
+        for (int s = 0; s < spurCount; ++s) {
+            int key = sidetrackKey(g, tree, destination, last, last.deviation + s, blockedNext[s], metric);
+            if (key >= 0) bound.offer(candidates.size() + s, key);
+        }
+
+        spurs.assign(std::max(spurCount, 0), Candidate());
+        spurFound.assign(std::max(spurCount, 0), 0);
+        auto search = [&](size_t s) {
+            int spurIndex = last.deviation + static_cast<int>(s);
+            spurFound[s] = spurRoute(g, tree, destination, last, spurIndex, blockedNext[s], metric, bound, spurs[s]);
+            if (spurFound[s]) bound.offer(candidates.size() + s, spurs[s].keys.back());
+        };
+        if (pool && spurCount > 1) {
+            pool->parallelFor(spurCount, search);
+        } else {
+            for (int s = 0; s < spurCount; ++s) search(s);
+        }
+
+        for (int s = 0; s < spurCount; ++s) {
+            if (!spurFound[s]) continue;
+            candidates.insert(std::move(spurs[s]));
+            if (candidates.size() > wanted) candidates.erase(std::prev(candidates.end()));
+        }
+        if (candidates.empty()) break;
+        accepted.push_back(*candidates.begin());
+        candidates.erase(candidates.begin());
+    }
+
+    routes.resize(accepted.size());
+    for (size_t i = 0; i < accepted.size(); ++i) {
+        routes[i].found = true;
+        routes[i].path = std::move(accepted[i].path);
+        routes[i].distance = accepted[i].distances.back();
+        routes[i].cost = accepted[i].costs.back();
+    }
+    return routes;
+}
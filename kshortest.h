@@ -0,0 +1,18 @@
+#ifndef KSHORTEST_H
+#define KSHORTEST_H
+
+#include <vector>
+#include "routing.h"
+
+class FrozenGraph;
+class ThreadPool;
+
+// Returns up to k loopless routes from origin to destination in increasing order of the metric (Yen's algorithm).
+// One backward search builds the shortest-path tree into destination, which every spur search shares: it is the
+// A* heuristic, and a spur search stops at the first settled airport whose tree route avoids the masked airports.
+// Spur searches mask airports and flights with per-thread stamps instead of copying the graph, and the spurs of
+// each accepted route run in parallel on the pool when one is given
+std::vector<RouteResult> kShortestRoutes(const FrozenGraph& g, int origin, int destination, int k, Metric metric = Metric::Distance,
+                                         ThreadPool* pool = nullptr);
+
+#endif
@@ -0,0 +1,132 @@
+#include "landmarks.h"
+#include "frozengraph.h"
+#include "threadpool.h"
+#include <algorithm>
+#include <limits>
+
+const int LandmarkIndex::UNREACHABLE = std::numeric_limits<int>::max();
+
+// Builds the index: picks up to count landmarks by farthest-point selection on flight distance, then
+// fills the distance and cost tables with one forward and one backward Dijkstra per landmark and metric,
+// all running in parallel on the pool
+void LandmarkIndex::build(const FrozenGraph& g, ThreadPool& pool, int count) {
+    n = g.vertexCount();
+    landmarks.clear();
+    if (n == 0 || count <= 0) return;
+
+    // Farthest-point selection: start from the airport farthest from airport 0, then keep adding the airport
+    // farthest from every landmark chosen so far. Airports no landmark reaches are only picked once every
+    // reachable one is covered, so landmarks stay in the large components
+    SearchWorkspace& ws = SearchWorkspace::local();
+    std::vector<int> nearest(n, UNREACHABLE); // Distance from the closest landmark
+    auto farthest = [&](const std::vector<int>& reach) {
+        int best = -1;
+        for (int v = 0; v < n; ++v) {
+            if (reach[v] != UNREACHABLE && reach[v] > 0 && (best == -1 || reach[v] > reach[best])) best = v;
+        }
+        if (best != -1) return best;
+        for (int v = 0; v < n; ++v) { // Everything reachable is a landmark already; open a new component
+            if (reach[v] == UNREACHABLE) return v;
+        }
+        return -1;
+    };
+    std::vector<int> fromStart(n, UNREACHABLE);
+    dijkstra(g, 0, -1, ws, Metric::Distance);
+    for (int v = 0; v < n; ++v) {
+        if (ws.reached(v)) fromStart[v] = ws.key(v);
+    }
+    int next = farthest(fromStart);
+    if (next == -1) next = 0;
+    while (next != -1 && static_cast<int>(landmarks.size()) < count) {
+        landmarks.push_back(next);
+        dijkstra(g, next, -1, ws, Metric::Distance);
+        for (int v = 0; v < n; ++v) {
+            if (ws.reached(v)) nearest[v] = std::min(nearest[v], ws.key(v));
+        }
+        next = farthest(nearest);
+    }
+
+    // Tables: task t covers landmark t / 4 with metric (t / 2) % 2, forwards when t is even
+    int chosen = landmarkCount();
+    for (int m = 0; m < 2; ++m) {
+        fromLandmark[m].assign(static_cast<size_t>(n) * chosen, UNREACHABLE);
+        toLandmark[m].assign(static_cast<size_t>(n) * chosen, UNREACHABLE);
+    }
+    pool.parallelFor(static_cast<size_t>(chosen) * 4, [&](size_t task) {
+        int l = static_cast<int>(task / 4);
+        int m = static_cast<int>(task / 2) % 2;
+        bool forward = task % 2 == 0;
+        SearchWorkspace& search = SearchWorkspace::local();
+        dijkstra(g, landmarks[l], -1, search, m == 0 ? Metric::Distance : Metric::Cost,
+                 forward ? Direction::Forward : Direction::Backward);
+        std::vector<int>& table = forward ? fromLandmark[m] : toLandmark[m];
+        for (int v = 0; v < n; ++v) {
+            if (search.reached(v)) table[static_cast<size_t>(v) * chosen + l] = search.key(v);
+        }
+    });
+}
+
+// Returns the bytes held by the landmark tables
+size_t LandmarkIndex::memoryBytes() const {
+    size_t bytes = landmarks.size() * sizeof(int);
+    for (int m = 0; m < 2; ++m) bytes += (fromLandmark[m].size() + toLandmark[m].size()) * sizeof(int);
+    return bytes;
+}
+
+// Returns the triangle-inequality lower bound on the metric from v to target; terms involving a landmark that
+// cannot be reached (or cannot reach) are skipped
+int LandmarkIndex::lowerBound(int v, int target, Metric metric) const {
+    int m = (metric == Metric::Distance) ? 0 : 1;
+    int count = landmarkCount();
+    const int* fromV = &fromLandmark[m][static_cast<size_t>(v) * count];
+    const int* fromT = &fromLandmark[m][static_cast<size_t>(target) * count];
+    const int* toV = &toLandmark[m][static_cast<size_t>(v) * count];
+    const int* toT = &toLandmark[m][static_cast<size_t>(target) * count];
+    int bound = 0;
+    for (int l = 0; l < count; ++l) {
+        if (toV[l] != UNREACHABLE && toT[l] != UNREACHABLE) bound = std::max(bound, toV[l] - toT[l]);
+        if (fromT[l] != UNREACHABLE && fromV[l] != UNREACHABLE) bound = std::max(bound, fromT[l] - fromV[l]);
+    }
+    return bound;
+}
+
+// A* search from origin to destination ordered by route length plus the landmark lower bound. The bounds are
+// consistent, so every settled airport is final and the result matches plain Dijkstra's length
+template <typename Probe>
+RouteResult LandmarkIndex::search(const FrozenGraph& g, int origin, int destination, Metric metric, Probe& probe) const {
+    RouteResult result;
+    SearchWorkspace& ws = SearchWorkspace::local();
+    int growths = ws.growthCount();
+    ws.begin(g.vertexCount());
+    probe.allocate(ws.growthCount() - growths);
+    if (g.mayReach(origin, destination)) {
+        ws.improve(origin, lowerBound(origin, destination, metric), 0, 0, -1, probe);
+        while (!ws.empty()) {
+            int u = ws.popMin();
+            probe.settle();
+            if (u == destination) break;
+
+            int distance = ws.distance(u), cost = ws.cost(u);
+            int length = (metric == Metric::Distance) ? distance : cost;
+            for (int e = g.edgeBegin(u); e < g.edgeEnd(u); ++e) {
+                int v = g.edgeTarget(e);
+                if (ws.settled(v) || !g.mayReach(v, destination)) continue;
+                int weight = (metric == Metric::Distance) ? g.edgeDistance(e) : g.edgeCost(e);
+                ws.improve(v, length + weight + lowerBound(v, destination, metric), distance + g.edgeDistance(e),
+                           cost + g.edgeCost(e), u, probe);
+            }
+        }
+        extractRoute(ws, destination, result);
+    }
+    return result;
+}
+
+// Landmark-guided route query; adds the search's work to stats when given some
+RouteResult LandmarkIndex::route(const FrozenGraph& g, int origin, int destination, Metric metric, SearchStats* stats) const {
+    if (stats) {
+        CountingProbe counting{*stats};
+        return search(g, origin, destination, metric, counting);
+    }
+    NoProbe silent;
+    return search(g, origin, destination, metric, silent);
+}
@@ -0,0 +1,41 @@
+#ifndef LANDMARKS_H
+#define LANDMARKS_H
+
+#include <cstddef>
+#include <vector>
+#include "routing.h"
+
+class FrozenGraph;
+class ThreadPool;
+
+// ALT (A*, landmarks, triangle inequality) index over a frozen graph. A handful of landmark airports are picked
+// by farthest-point selection, and the distance and cost of the shortest route from and to every landmark are
+// tabulated for every airport. For a query towards t, max over landmarks L of d(v, L) - d(t, L) and
+// d(L, t) - d(L, v) is a lower bound on d(v, t), which steers an A* search towards the destination.
+// The bounds hold only for the graph the index was built on; rebuild it whenever flights change.
+class LandmarkIndex {
+private:
+    static const int UNREACHABLE;
+
+    int n = 0;
+    std::vector<int> landmarks;
+    // Tables indexed [v * landmarkCount + l], one pair per metric (0 = distance, 1 = cost)
+    std::vector<int> fromLandmark[2]; // Shortest route landmark -> v
+    std::vector<int> toLandmark[2];   // Shortest route v -> landmark
+
+    int lowerBound(int v, int target, Metric metric) const;
+    template <typename Probe>
+    RouteResult search(const FrozenGraph& g, int origin, int destination, Metric metric, Probe& probe) const;
+
+public: // See implementation file for details
+    void build(const FrozenGraph& g, ThreadPool& pool, int count = 16);
+
+    int vertexCount() const { return n; }
+    int landmarkCount() const { return static_cast<int>(landmarks.size()); }
+    const std::vector<int>& getLandmarks() const { return landmarks; }
+    size_t memoryBytes() const;
+    RouteResult route(const FrozenGraph& g, int origin, int destination, Metric metric = Metric::Distance,
+                      SearchStats* stats = nullptr) const;
+};
+
+#endif
@@ -0,0 +1,174 @@
+#include "loader.h"
+#include "graph.h"
+#include "mappedfile.h"
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <string_view>
+#include <thread>
+
+namespace {
+
+const size_t MIN_CHUNK_BYTES = 1 << 16;
+const int FIELD_COUNT = 6;
+const size_t MAX_CODE_LENGTH = 0xFF; // Longest code the metadata store accepts
+
+// Rows and issues scanned from one chunk; issue line numbers are relative to the chunk until merged
+struct Chunk {
+    const char* begin;
+    const char* end;
+    size_t lineCount = 0;
+    std::vector<Graph::FlightView> rows;
+    std::vector<LoadIssue> issues;
+};
+
+// Strips surrounding spaces and tabs
+std::string_view trim(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) s.remove_suffix(1);
+    return s;
+}
+
+// Splits a line into exactly FIELD_COUNT comma-separated fields. Quoted fields may contain commas and come back
+// without their quotes. Returns an error message, or nullptr on success
+const char* splitFields(std::string_view line, std::string_view* fields) {
+    size_t pos = 0;
+    for (int f = 0; f < FIELD_COUNT; ++f) {
+        if (pos > line.size()) return "too few fields";
+        if (pos < line.size() && line[pos] == '"') {
+            size_t close = line.find('"', pos + 1);
+            while (close != std::string_view::npos && close + 1 < line.size() && line[close + 1] == '"') {
+                close = line.find('"', close + 2); // Doubled quote inside the field
+            }
+            if (close == std::string_view::npos) return "unterminated quoted field";
+            fields[f] = line.substr(pos + 1, close - pos - 1);
+            pos = close + 1;
+            if (pos < line.size() && line[pos] != ',') return "text after closing quote";
+        } else {
+            size_t comma = line.find(',', pos);
+            if (comma == std::string_view::npos) comma = line.size();
+            fields[f] = trim(line.substr(pos, comma - pos));
+            pos = comma;
+        }
+        pos++; // Skip the comma
+    }
+    if (pos <= line.size()) return "too many fields";
+    return nullptr;
+}
+
+// Parses a whole field as a non-negative int
+bool parseInt(std::string_view field, int& value) {
+    const char* end = field.data() + field.size();
+    auto result = std::from_chars(field.data(), end, value);
+    return result.ec == std::errc() && result.ptr == end && !field.empty() && value >= 0;
+}
+
+// Returns the state part of a "City, ST" field (text after the last comma)
+std::string_view stateOf(std::string_view cityField) {
+    size_t comma = cityField.rfind(',');
+    if (comma == std::string_view::npos) return std::string_view();
+    return trim(cityField.substr(comma + 1));
+}
+
+// Returns the city part of a "City, ST" field (text before the last comma)
+std::string_view cityOf(std::string_view cityField) {
+    size_t comma = cityField.rfind(',');
+    if (comma == std::string_view::npos) return std::string_view();
+    return trim(cityField.substr(0, comma));
+}
+
+// Scans every line of a chunk
+void scanChunk(Chunk& chunk) {
+    std::string_view fields[FIELD_COUNT];
+    const char* p = chunk.begin;
+    while (p < chunk.end) {
+        const char* newline = std::find(p, chunk.end, '\n');
+        std::string_view line(p, newline - p);
+        p = (newline == chunk.end) ? newline : newline + 1;
+        chunk.lineCount++;
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        if (trim(line).empty()) continue;
+
+        Graph::FlightView row;
+        const char* problem = splitFields(line, fields);
+        if (!problem && (fields[0].empty() || fields[1].empty())) problem = "missing airport code";
+        if (!problem && (fields[0].size() > MAX_CODE_LENGTH || fields[1].size() > MAX_CODE_LENGTH)) {
+            problem = "airport code longer than 255 characters";
+        }
+        if (!problem) {
+            row.origin = fields[0];
+            row.dest = fields[1];
+            row.originState = stateOf(fields[2]);
+            row.destState = stateOf(fields[3]);
+            row.originCity = cityOf(fields[2]);
+            row.destCity = cityOf(fields[3]);
+            if (row.originState.empty() || row.destState.empty()) problem = "city field is not \"City, ST\"";
+        }
+        if (!problem && !parseInt(fields[4], row.distance)) problem = "distance is not a non-negative integer";
+        if (!problem && !parseInt(fields[5], row.cost)) problem = "cost is not a non-negative integer";
+        if (problem) {
+            chunk.issues.push_back({chunk.lineCount, problem});
+            continue;
+        }
+        chunk.rows.push_back(row);
+    }
+}
+
+} // namespace
+
+// Loads a route file into the graph. The file is memory-mapped and its first line is treated as a header
+LoadReport loadFlightsFile(const std::string& filename, Graph& g, int threadCount) {
+    MappedFile file;
+    if (!file.open(filename)) return LoadReport();
+    return loadFlightsText(file.data(), file.size(), g, threadCount);
+}
+
+// Loads route rows from an in-memory copy of a route file (first line is the header)
+LoadReport loadFlightsText(const char* text, size_t size, Graph& g, int threadCount) {
+    LoadReport report;
+    report.opened = true;
+    const char* end = text + size;
+    const char* body = std::find(text, end, '\n');
+    if (body == end) return report; // Header only
+    body++;
+
+    // Split into chunks that end on line boundaries
+    if (threadCount <= 0) threadCount = std::max(1u, std::thread::hardware_concurrency());
+    size_t target = std::max(MIN_CHUNK_BYTES, static_cast<size_t>(end - body) / (threadCount * 4) + 1);
+    std::vector<Chunk> chunks;
+    for (const char* p = body; p < end;) {
+        const char* stop = (static_cast<size_t>(end - p) <= target) ? end : std::find(p + target, end, '\n');
+        if (stop != end) stop++;
+        chunks.push_back({p, stop, 0, {}, {}});
+        p = stop;
+    }
+
+    // Scan chunks in parallel
+    std::atomic<size_t> next(0);
+    auto worker = [&] {
+        for (size_t i = next++; i < chunks.size(); i = next++) scanChunk(chunks[i]);
+    };
+    std::vector<std::thread> workers;
+    int extra = std::min<int>(threadCount, static_cast<int>(chunks.size())) - 1;
+    for (int t = 0; t < extra; ++t) workers.emplace_back(worker);
+    worker();
+    for (auto& thread : workers) thread.join();
+
+    // Merge in file order: fix up line numbers and add every row in one batch
+    std::vector<Graph::FlightView> rows;
+    size_t total = 0;
+    for (const auto& chunk : chunks) total += chunk.rows.size();
+    rows.reserve(total);
+    size_t firstLine = 2;
+    for (auto& chunk : chunks) {
+        rows.insert(rows.end(), chunk.rows.begin(), chunk.rows.end());
+        for (auto& issue : chunk.issues) {
+            issue.line += firstLine - 1;
+            report.errors.push_back(std::move(issue));
+        }
+        firstLine += chunk.lineCount;
+    }
+    g.addFlights(rows);
+    report.rows = rows.size();
+    return report;
+}
@@ -0,0 +1,30 @@
+#ifndef LOADER_H
+#define LOADER_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+class Graph;
+
+// Malformed input row
+struct LoadIssue {
+    size_t line; // 1-based line number in the file (the header is line 1)
+    std::string message;
+};
+
+// Outcome of loading a route file
+struct LoadReport {
+    bool opened = false;
+    size_t rows = 0; // Rows added to the graph
+    std::vector<LoadIssue> errors;
+};
+
+// Parallel route-file loader. The input is split into chunks on line boundaries, each chunk is scanned on its
+// own thread into rows that view the input text (quote-aware field scanning, std::from_chars for numbers),
+// and the rows are then added to the graph in file order with one batched insert.
+// Row format: Origin,Destination,"Origin City, ST","Destination City, ST",Distance,Cost
+LoadReport loadFlightsFile(const std::string& filename, Graph& g, int threadCount = 0);
+LoadReport loadFlightsText(const char* text, size_t size, Graph& g, int threadCount = 0);
+
+#endif
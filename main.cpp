@@ -1,63 +1,20 @@
-#include <fstream>
-#include <sstream>
 #include <iostream>
 #include "graph.h"
+#include "loader.h"
 #include <string>
 
 // Loads a given text file into a given graph object. OnlineGDB does not recognize .csv files, so this will have to do.
+// Malformed rows are skipped and reported with their line numbers.
 void loadTXT(const std::string& filename, Graph& g) {
-    // Open file
-    std::ifstream file(filename);
+    LoadReport report = loadFlightsFile(filename, g);
     // Ensure file is actually open
-    if (!file.is_open()) {
+    if (!report.opened) {
         std::cerr << "Failed to open " << filename << std::endl;
         return;
     }
-    
-    // Define line object
-    std::string line;
-    getline(file, line);
-    
-    // Iterate through file lines and add airports & graphs
-    while (getline(file, line)) {
-        std::stringstream ss(line);
-        std::string origin, dest, originCity, originState, destCity, destState, distStr, costStr;
-        
-        // Gather variable data
-        getline(ss, origin, ',');
-        getline(ss, dest, ',');
-        
-        // Handle city strings properly
-        if (ss.peek() == '"') ss.ignore();
-        getline(ss, originCity, ',');
-        
-        if (ss.peek() == ' ') ss.ignore();
-        getline(ss, originState, '"');
-        
-        ss.ignore(1, ',');
-        
-        if (ss.peek() == '"') ss.ignore();
-        getline(ss, destCity, ',');
-        
-        if (ss.peek() == ' ') ss.ignore();
-        getline(ss, destState, '"');
-        
-        ss.ignore(1, ',');
-
-        getline(ss, distStr, ',');
-        getline(ss, costStr, ',');
-        
-        int distance = std::stoi(distStr);
-        int cost = std::stoi(costStr);
-        
-        // Add airports and flights
-        g.addAirport(origin, originState);
-        g.addAirport(dest, destState);
-        g.addFlight(origin, dest, distance, cost);
+    for (const auto& issue : report.errors) {
+        std::cerr << filename << ":" << issue.line << ": " << issue.message << std::endl;
     }
-    
-    // Close file
-    file.close();
 }
 
 // Main function
@@ -77,7 +34,7 @@ int main() {
     g.printFlightConnections(); // 5)
     std::cout << std::endl;
     
-    Graph g_u = g.createUndirectedGraph(); // 6)
+    const Graph& g_u = g.undirectedView(); // 6)
     
     g_u.primMST(); // 7)
     std::cout << std::endl;
@@ -0,0 +1,40 @@
+#include "mappedfile.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Unmaps the file
+MappedFile::~MappedFile() {
+    close();
+}
+
+// Maps the whole file read-only. Returns whether it succeeded; an empty file maps to a null, zero-length view
+bool MappedFile::open(const std::string& path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd == -1) return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        ::close(fd);
+        return false;
+    }
+    if (info.st_size > 0) {
+        void* mapped = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        if (mapped == MAP_FAILED) {
+            ::close(fd);
+            return false;
+        }
+        address = mapped;
+        length = static_cast<size_t>(info.st_size);
+    }
+    ::close(fd);
+    return true;
+}
+
+// Releases the mapping, if any
+void MappedFile::close() {
+    if (address) munmap(address, length);
+    address = nullptr;
+    length = 0;
+}
@@ -0,0 +1,25 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+
+// Read-only, shared memory mapping of a whole file. Processes mapping the same file share its pages
+class MappedFile {
+private:
+    void* address = nullptr;
+    size_t length = 0;
+
+public: // See implementation file for details
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+
+    bool open(const std::string& path);
+    void close();
+    const char* data() const { return static_cast<const char*>(address); }
+    size_t size() const { return length; }
+};
+
+#endif
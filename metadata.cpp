@@ -0,0 +1,140 @@
+#include "metadata.h"
+#include <functional>
+
+// StringTable methods
+// Returns the slot holding s, or the empty slot where it would go. The table must not be full
+size_t StringTable::findSlot(std::string_view s) const {
+    size_t mask = slots.size() - 1;
+    size_t slot = std::hash<std::string_view>()(s) & mask;
+    while (slots[slot] != 0 && get(slots[slot] - 1) != s) slot = (slot + 1) & mask;
+    return slot;
+}
+
+// Doubles the lookup table (keeping it at most half full) and reinserts every id
+void StringTable::grow() {
+    std::vector<uint32_t> old;
+    old.swap(slots);
+    slots.assign(old.empty() ? 16 : old.size() * 2, 0);
+    for (uint32_t id = 0; id < static_cast<uint32_t>(size()); ++id) slots[findSlot(get(id))] = id + 1;
+}
+
+// Returns the id of s, adding it to the table first if it is new
+uint32_t StringTable::intern(std::string_view s) {
+    if ((size() + 1) * 2 > slots.size()) grow();
+    size_t slot = findSlot(s);
+    if (slots[slot] != 0) return slots[slot] - 1;
+
+    uint32_t id = static_cast<uint32_t>(size());
+    arena.append(s);
+    offsets.push_back(static_cast<uint32_t>(arena.size()));
+    slots[slot] = id + 1;
+    return id;
+}
+
+// Returns the id of s, or -1 if it was never interned
+int StringTable::find(std::string_view s) const {
+    if (slots.empty()) return -1;
+    uint32_t entry = slots[findSlot(s)];
+    return static_cast<int>(entry) - 1;
+}
+
+// Returns the bytes held by the arena, offsets and lookup table
+size_t StringTable::memoryBytes() const {
+    return arena.capacity() + offsets.capacity() * sizeof(uint32_t) + slots.capacity() * sizeof(uint32_t);
+}
+
+// AirportMetadata methods
+// Packs a code of one to four 7-bit characters into key, first character in the high byte. Returns false for
+// codes that do not fit (they go to the overflow arena)
+bool AirportMetadata::pack(std::string_view code, uint32_t& key) {
+    if (code.empty() || code.size() > 4) return false;
+    key = 0;
+    for (size_t i = 0; i < 4; ++i) {
+        unsigned char c = (i < code.size()) ? static_cast<unsigned char>(code[i]) : 0;
+        if (i < code.size() && (c == 0 || c >= 0x80)) return false;
+        key = (key << 8) | c;
+    }
+    return true;
+}
+
+// Returns the code of airport v; packed codes are unpacked into buffer. Views of long codes are valid until the
+// next insert
+std::string_view AirportMetadata::codeView(int v, char (&buffer)[4]) const {
+    uint32_t key = codes[v];
+    if (key & OVERFLOW_BIT) {
+        uint32_t at = key & ~OVERFLOW_BIT;
+        return std::string_view(longCodes).substr(at + 1, static_cast<unsigned char>(longCodes[at]));
+    }
+    size_t length = 0;
+    while (length < 4 && ((key >> (24 - 8 * length)) & 0xFF) != 0) {
+        buffer[length] = static_cast<char>((key >> (24 - 8 * length)) & 0xFF);
+        length++;
+    }
+    return std::string_view(buffer, length);
+}
+
+// Returns the index slot holding code, or the empty slot where it would go
+size_t AirportMetadata::findSlot(std::string_view code) const {
+    size_t mask = codeSlots.size() - 1;
+    size_t slot = std::hash<std::string_view>()(code) & mask;
+    char buffer[4];
+    while (codeSlots[slot] != 0 && codeView(codeSlots[slot] - 1, buffer) != code) slot = (slot + 1) & mask;
+    return slot;
+}
+
+// Rebuilds the code index with the given number of slots (a power of two)
+void AirportMetadata::resizeIndex(size_t slotCount) {
+    codeSlots.assign(slotCount, 0);
+    char buffer[4];
+    for (int v = 0; v < size(); ++v) codeSlots[findSlot(codeView(v, buffer))] = v + 1;
+}
+
+// Reserves room for the given number of airports so bulk loads don't keep rehashing/reallocating
+void AirportMetadata::reserve(size_t airportCount) {
+    codes.reserve(airportCount);
+    stateIds.reserve(airportCount);
+    cityIds.reserve(airportCount);
+    size_t wanted = 16;
+    while (wanted < airportCount * 2) wanted *= 2;
+    if (codeSlots.size() < wanted) resizeIndex(wanted);
+}
+
+// Adds an airport unless its code is already known. Returns its index and whether it was added
+std::pair<int, bool> AirportMetadata::insert(std::string_view code, std::string_view state, std::string_view city) {
+    if ((codes.size() + 1) * 2 > codeSlots.size()) resizeIndex(codeSlots.empty() ? 16 : codeSlots.size() * 2);
+    size_t slot = findSlot(code);
+    if (codeSlots[slot] != 0) return {codeSlots[slot] - 1, false};
+
+    if (code.size() > 0xFF) throw std::string("Airport code too long: ") + std::string(code.substr(0, 16)) + "...";
+    uint32_t stateId = states.intern(state);
+    uint32_t cityId = cities.intern(city);
+    uint32_t key;
+    if (!pack(code, key)) {
+        key = OVERFLOW_BIT | static_cast<uint32_t>(longCodes.size());
+        longCodes.push_back(static_cast<char>(code.size()));
+        longCodes.append(code);
+    }
+    codes.push_back(key);
+    stateIds.push_back(stateId);
+    cityIds.push_back(cityId);
+    codeSlots[slot] = size();
+    return {size() - 1, true};
+}
+
+// Attempts to find and return the index of the given airport code. If not found, returns -1
+int AirportMetadata::find(std::string_view code) const {
+    if (codeSlots.empty()) return -1;
+    return codeSlots[findSlot(code)] - 1;
+}
+
+// Returns the airport code of airport v
+std::string AirportMetadata::code(int v) const {
+    char buffer[4];
+    return std::string(codeView(v, buffer));
+}
+
+// Returns the bytes held by the per-airport arrays, the code index and the name tables
+size_t AirportMetadata::memoryBytes() const {
+    return codes.capacity() * sizeof(uint32_t) + (stateIds.capacity() + cityIds.capacity()) * sizeof(uint32_t) +
+           codeSlots.capacity() * sizeof(int) + longCodes.capacity() + states.memoryBytes() + cities.memoryBytes();
+}
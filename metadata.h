@@ -0,0 +1,67 @@
+#ifndef METADATA_H
+#define METADATA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Interned string table: every distinct string is stored once, back to back in one arena, and named by a dense
+// id. Lookups go through an open-addressing table of ids, so nothing points into the arena and it can grow freely
+class StringTable {
+private:
+    std::string arena;
+    std::vector<uint32_t> offsets{0}; // String id spans [offsets[id], offsets[id + 1]) of the arena
+    std::vector<uint32_t> slots;      // Id + 1 per slot, 0 if empty; the size is a power of two
+
+    size_t findSlot(std::string_view s) const;
+    void grow();
+
+public: // See implementation file for details
+    uint32_t intern(std::string_view s);
+    int find(std::string_view s) const;
+    std::string_view get(uint32_t id) const { return std::string_view(arena).substr(offsets[id], offsets[id + 1] - offsets[id]); }
+    int size() const { return static_cast<int>(offsets.size()) - 1; }
+    size_t memoryBytes() const;
+};
+
+// Compact per-airport metadata, kept apart from the flight adjacency. Each airport costs 12 bytes plus its slot in
+// the code index: a 4-byte code key and 32-bit state and city ids into interned name tables.
+// Codes of up to four characters (every IATA code) are packed into the key, first character in the high byte;
+// longer codes are appended to an overflow arena and the key holds their position with the top bit set.
+class AirportMetadata {
+private:
+    static const uint32_t OVERFLOW_BIT = 0x80000000u;
+
+    std::vector<uint32_t> codes;
+    std::vector<uint32_t> stateIds;
+    std::vector<uint32_t> cityIds;
+    StringTable states;
+    StringTable cities;
+    std::string longCodes;             // Overflow arena: each long code is stored with a leading length byte
+    std::vector<int> codeSlots;        // Open-addressing index by code: airport index + 1 per slot, 0 if empty
+
+    static bool pack(std::string_view code, uint32_t& key);
+    std::string_view codeView(int v, char (&buffer)[4]) const;
+    size_t findSlot(std::string_view code) const;
+    void resizeIndex(size_t slotCount);
+
+public: // See implementation file for details
+    void reserve(size_t airportCount);
+    std::pair<int, bool> insert(std::string_view code, std::string_view state, std::string_view city = {});
+    int find(std::string_view code) const;
+
+    int size() const { return static_cast<int>(codes.size()); }
+    std::string code(int v) const;
+    std::string_view state(int v) const { return states.get(stateIds[v]); }
+    std::string_view city(int v) const { return cities.get(cityIds[v]); }
+    int stateId(int v) const { return stateIds[v]; }
+    int stateCount() const { return states.size(); }
+    std::string_view stateName(int id) const { return states.get(id); }
+    int findState(std::string_view state) const { return states.find(state); }
+    size_t memoryBytes() const;
+};
+
+#endif
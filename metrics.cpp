@@ -0,0 +1,192 @@
+#include "metrics.h"
+#include <algorithm>
+#include <sstream>
+
+// QueryMetrics methods
+// Returns the process-wide metrics
+QueryMetrics& QueryMetrics::global() {
+    static QueryMetrics metrics;
+    return metrics;
+}
+
+// Returns the calling thread's block, registering it on the thread's first query. Blocks outlive their threads,
+// so the counts of finished pool workers still show up in dumps
+QueryMetrics::ThreadBlock& QueryMetrics::local() {
+    thread_local ThreadBlock* block = nullptr;
+    if (!block) {
+        std::lock_guard<std::mutex> guard(registryLock);
+        blocks.push_back(std::make_unique<ThreadBlock>());
+        block = blocks.back().get();
+    }
+    return *block;
+}
+
+// Turns collection on or off. Queries already running finish in the mode they started in
+void QueryMetrics::enable(bool on) {
+    collecting.store(on, std::memory_order_relaxed);
+}
+
+// Adds one finished query to the calling thread's counters
+void QueryMetrics::record(Query query, const SearchStats& stats) {
+    Counters& c = local().counters[static_cast<int>(query)];
+    c.queries.fetch_add(1, std::memory_order_relaxed);
+    c.settled.fetch_add(stats.settled, std::memory_order_relaxed);
+    c.relaxed.fetch_add(stats.relaxed, std::memory_order_relaxed);
+    c.pushes.fetch_add(stats.pushes, std::memory_order_relaxed);
+    c.decreaseKeys.fetch_add(stats.decreaseKeys, std::memory_order_relaxed);
+    c.allocations.fetch_add(stats.allocations, std::memory_order_relaxed);
+    c.wallNs.fetch_add(stats.wallNs, std::memory_order_relaxed);
+    if (static_cast<uint64_t>(stats.queuePeak) > c.queuePeak.load(std::memory_order_relaxed)) {
+        c.queuePeak.store(stats.queuePeak, std::memory_order_relaxed); // Only this thread writes the block
+    }
+
+    uint64_t micros = stats.wallNs / 1000;
+    int bucket = 0;
+    while (bucket < LATENCY_BUCKETS - 1 && (uint64_t(1) << bucket) <= micros) bucket++;
+    c.latency[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+// Zeroes every counter. Queries recorded while the reset runs may be partly kept
+void QueryMetrics::reset() {
+    std::lock_guard<std::mutex> guard(registryLock);
+    for (auto& block : blocks) {
+        for (Counters& c : block->counters) {
+            for (auto* counter : {&c.queries, &c.settled, &c.relaxed, &c.pushes, &c.decreaseKeys, &c.allocations, &c.wallNs,
+                                  &c.queuePeak}) {
+                counter->store(0, std::memory_order_relaxed);
+            }
+            for (auto& bucket : c.latency) bucket.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+// Sums one query type's counters over every thread
+QueryMetrics::Totals QueryMetrics::totals(Query query) const {
+    Totals sum;
+    std::lock_guard<std::mutex> guard(registryLock);
+    for (const auto& block : blocks) {
+        const Counters& c = block->counters[static_cast<int>(query)];
+        sum.queries += c.queries.load(std::memory_order_relaxed);
+        sum.settled += c.settled.load(std::memory_order_relaxed);
+        sum.relaxed += c.relaxed.load(std::memory_order_relaxed);
+        sum.pushes += c.pushes.load(std::memory_order_relaxed);
+        sum.decreaseKeys += c.decreaseKeys.load(std::memory_order_relaxed);
+        sum.allocations += c.allocations.load(std::memory_order_relaxed);
+        sum.wallNs += c.wallNs.load(std::memory_order_relaxed);
+        sum.queuePeak = std::max(sum.queuePeak, c.queuePeak.load(std::memory_order_relaxed));
+        for (int b = 0; b < LATENCY_BUCKETS; ++b) sum.latency[b] += c.latency[b].load(std::memory_order_relaxed);
+    }
+    return sum;
+}
+
+// Returns the label used for a query type in dumps
+const char* QueryMetrics::name(Query query) {
+    switch (query) {
+    case Query::Route: return "route";
+    case Query::RouteWithStops: return "route_with_stops";
+    default: return "routes_to_state";
+    }
+}
+
+// Dumps the metrics as one JSON object keyed by query type. Latency buckets are per bucket (not cumulative),
+// keyed by their upper bound in microseconds
+std::string QueryMetrics::toJson() const {
+    std::ostringstream out;
+    out << "{";
+    for (int q = 0; q < QUERY_TYPES; ++q) {
+        Query query = static_cast<Query>(q);
+        Totals t = totals(query);
+        out << (q ? "," : "") << "\"" << name(query) << "\":{\"queries\":" << t.queries << ",\"settled\":" << t.settled
+            << ",\"relaxed\":" << t.relaxed << ",\"pushes\":" << t.pushes << ",\"decrease_keys\":" << t.decreaseKeys
+            << ",\"allocations\":" << t.allocations << ",\"queue_peak\":" << t.queuePeak << ",\"wall_ns\":" << t.wallNs
+            << ",\"latency_us\":{";
+        for (int b = 0; b < LATENCY_BUCKETS; ++b) {
+            out << (b ? "," : "") << "\"";
+            if (b == LATENCY_BUCKETS - 1) {
+                out << "+Inf";
+            } else {
+                out << (uint64_t(1) << b);
+            }
+            out << "\":" << t.latency[b];
+        }
+        out << "}}";
+    }
+    out << "}";
+    return out.str();
+}
+
+// Dumps the metrics in the Prometheus text exposition format, with a cumulative latency histogram in seconds
+std::string QueryMetrics::toPrometheus() const {
+    struct Counter {
+        const char* metric;
+        const char* help;
+        uint64_t Totals::*field;
+    };
+    static const Counter counters[] = {
+        {"flight_queries_total", "Queries answered", &Totals::queries},
+        {"flight_search_settled_total", "Vertices settled by query searches", &Totals::settled},
+        {"flight_search_relaxed_total", "Flights relaxed by query searches", &Totals::relaxed},
+        {"flight_search_pushes_total", "Vertices first queued by query searches", &Totals::pushes},
+        {"flight_search_decrease_keys_total", "Queued labels improved by query searches", &Totals::decreaseKeys},
+        {"flight_search_allocations_total", "Search workspace buffer growths", &Totals::allocations},
+    };
+
+    Totals totalsByQuery[QUERY_TYPES];
+    for (int q = 0; q < QUERY_TYPES; ++q) totalsByQuery[q] = totals(static_cast<Query>(q));
+
+    std::ostringstream out;
+    for (const Counter& counter : counters) {
+        out << "# HELP " << counter.metric << " " << counter.help << "\n# TYPE " << counter.metric << " counter\n";
+        for (int q = 0; q < QUERY_TYPES; ++q) {
+            out << counter.metric << "{query=\"" << name(static_cast<Query>(q)) << "\"} " << totalsByQuery[q].*counter.field << "\n";
+        }
+    }
+    out << "# HELP flight_search_queue_peak Largest priority queue or hop frontier of any query\n"
+        << "# TYPE flight_search_queue_peak gauge\n";
+    for (int q = 0; q < QUERY_TYPES; ++q) {
+        out << "flight_search_queue_peak{query=\"" << name(static_cast<Query>(q)) << "\"} " << totalsByQuery[q].queuePeak << "\n";
+    }
+    out << "# HELP flight_query_latency_seconds Query wall time\n# TYPE flight_query_latency_seconds histogram\n";
+    for (int q = 0; q < QUERY_TYPES; ++q) {
+        const char* label = name(static_cast<Query>(q));
+        const Totals& t = totalsByQuery[q];
+        uint64_t cumulative = 0;
+        for (int b = 0; b < LATENCY_BUCKETS; ++b) {
+            cumulative += t.latency[b];
+            out << "flight_query_latency_seconds_bucket{query=\"" << label << "\",le=\"";
+            if (b == LATENCY_BUCKETS - 1) {
+                out << "+Inf";
+            } else {
+                out << (uint64_t(1) << b) * 1e-6;
+            }
+            out << "\"} " << cumulative << "\n";
+        }
+        out << "flight_query_latency_seconds_sum{query=\"" << label << "\"} " << t.wallNs * 1e-9 << "\n"
+            << "flight_query_latency_seconds_count{query=\"" << label << "\"} " << t.queries << "\n";
+    }
+    return out.str();
+}
+
+// QueryTimer methods
+// Starts measuring a query if the caller wants its stats or metrics are being collected
+QueryTimer::QueryTimer(QueryMetrics::Query query, SearchStats* requested)
+    : requested(requested), query(query), recording(QueryMetrics::global().enabled()) {
+    measuring = requested || recording;
+    if (measuring) start = std::chrono::steady_clock::now();
+}
+
+// Fills in the wall time, records the query and adds its stats to the caller's, as SearchStats totals across
+// queries (the queue peak is the larger of the two)
+QueryTimer::~QueryTimer() {
+    if (!measuring) return;
+    own.wallNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    if (recording) QueryMetrics::global().record(query, own);
+    if (!requested) return;
+    requested->settled += own.settled;
+    requested->relaxed += own.relaxed;
+    requested->pushes += own.pushes;
+    requested->decreaseKeys += own.decreaseKeys;
+    requested->queuePeak = std::max(requested->queuePeak, own.queuePeak);
+    requested->allocations += own.allocations;
+    requested->wallNs += own.wallNs;
+}
@@ -0,0 +1,87 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "routing.h"
+
+// Process-wide query metrics: per query type, the number of queries, the search work they did and a latency
+// histogram. Each thread records into its own block of relaxed atomics, so recording never locks or shares a
+// cache line with another thread; dumps sum the blocks. Collection is off by default, and while it is off the
+// query engines skip the clock and run their uninstrumented builds.
+class QueryMetrics {
+public:
+    enum class Query { Route, RouteWithStops, RoutesToState };
+    static const int QUERY_TYPES = 3;
+    static const int LATENCY_BUCKETS = 24; // Bucket b counts queries under 2^b microseconds; the last one counts the rest
+
+private:
+    struct Counters {
+        std::atomic<uint64_t> queries{0};
+        std::atomic<uint64_t> settled{0};
+        std::atomic<uint64_t> relaxed{0};
+        std::atomic<uint64_t> pushes{0};
+        std::atomic<uint64_t> decreaseKeys{0};
+        std::atomic<uint64_t> allocations{0};
+        std::atomic<uint64_t> wallNs{0};
+        std::atomic<uint64_t> queuePeak{0}; // Largest over all queries
+        std::atomic<uint64_t> latency[LATENCY_BUCKETS] = {};
+    };
+
+    // One thread's counters, written only by that thread
+    struct alignas(64) ThreadBlock {
+        Counters counters[QUERY_TYPES];
+    };
+
+    // Counters summed over every thread
+    struct Totals {
+        uint64_t queries = 0, settled = 0, relaxed = 0, pushes = 0, decreaseKeys = 0, allocations = 0, wallNs = 0, queuePeak = 0;
+        uint64_t latency[LATENCY_BUCKETS] = {};
+    };
+
+    mutable std::mutex registryLock; // Guards blocks; taken once per thread and by dumps
+    std::vector<std::unique_ptr<ThreadBlock>> blocks;
+    std::atomic<bool> collecting{false};
+
+    ThreadBlock& local();
+    Totals totals(Query query) const;
+    static const char* name(Query query);
+
+public: // See implementation file for details
+    static QueryMetrics& global();
+
+    void enable(bool on);
+    bool enabled() const { return collecting.load(std::memory_order_relaxed); }
+    void record(Query query, const SearchStats& stats);
+    void reset();
+    std::string toJson() const;
+    std::string toPrometheus() const;
+};
+
+// Measures one query. When the caller asked for stats, or metrics are being collected, stats() points at a
+// fresh SearchStats for the engines to count into, and the destructor fills in the wall time, records the query
+// and adds it to the caller's stats; otherwise stats() is nullptr, which selects the engines' uninstrumented builds
+class QueryTimer {
+private:
+    SearchStats own;
+    SearchStats* requested;
+    bool measuring;
+    QueryMetrics::Query query;
+    bool recording;
+    std::chrono::steady_clock::time_point start;
+
+public: // See implementation file for details
+    QueryTimer(QueryMetrics::Query query, SearchStats* requested);
+    QueryTimer(const QueryTimer&) = delete;
+    QueryTimer& operator=(const QueryTimer&) = delete;
+    ~QueryTimer();
+
+    SearchStats* stats() { return measuring ? &own : nullptr; }
+};
+
+#endif
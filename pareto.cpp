@@ -0,0 +1,112 @@
+#include "pareto.h"
+#include "frozengraph.h"
+#include <algorithm>
+#include <limits>
+
+// ParetoWorkspace methods
+// Returns this thread's workspace
+ParetoWorkspace& ParetoWorkspace::local() {
+    thread_local ParetoWorkspace workspace;
+    return workspace;
+}
+
+// Query engines
+// Bi-objective label-setting search. Labels are settled in lexicographic (distance, cost) order of their
+// lower-bounded totals, so a label is dominated exactly when its cost is no better than the best cost already
+// settled at its vertex or at the destination. The lower bounds come from two backward single-criterion searches.
+std::vector<RouteResult> paretoRoutes(const FrozenGraph& g, int origin, int destination, ParetoWorkspace& ws) {
+    const int INF = std::numeric_limits<int>::max();
+    int n = g.vertexCount();
+    std::vector<RouteResult> frontier;
+    if (!g.mayReach(origin, destination)) return frontier;
+
+    // Per-vertex state
+    if (ws.stamp.size() < n) {
+        ws.stamp.resize(n, 0);
+        ws.lowerDistance.resize(n);
+        ws.lowerCost.resize(n);
+        ws.bestCost.resize(n);
+    }
+    if (++ws.epoch == 0) { // Stamp counter wrapped; old stamps could look current again
+        std::fill(ws.stamp.begin(), ws.stamp.end(), 0);
+        ws.epoch = 1;
+    }
+    ws.labels.clear();
+    ws.heap.clear();
+
+    // Lower bounds from the destination; vertices that cannot reach it are never stamped
+    SearchWorkspace& bounds = SearchWorkspace::local();
+    dijkstra(g, destination, -1, bounds, Metric::Cost, Direction::Backward);
+    if (!bounds.reached(origin)) return frontier;
+    for (int v = 0; v < n; ++v) {
+        if (!bounds.reached(v)) continue;
+        ws.stamp[v] = ws.epoch;
+        ws.lowerCost[v] = bounds.key(v);
+        ws.bestCost[v] = INF;
+    }
+    dijkstra(g, destination, -1, bounds, Metric::Distance, Direction::Backward);
+    for (int v = 0; v < n; ++v) {
+        if (ws.stamp[v] == ws.epoch) ws.lowerDistance[v] = bounds.key(v);
+    }
+
+    // Heap ordered by (distance + lowerDistance, cost + lowerCost)
+    auto later = [&](int a, int b) {
+        const auto& la = ws.labels[a];
+        const auto& lb = ws.labels[b];
+        long long fa = (long long)la.distance + ws.lowerDistance[la.vertex];
+        long long fb = (long long)lb.distance + ws.lowerDistance[lb.vertex];
+        if (fa != fb) return fa > fb;
+        return la.cost + ws.lowerCost[la.vertex] > lb.cost + ws.lowerCost[lb.vertex];
+    };
+    auto push = [&](int vertex, int distance, int cost, int parent) {
+        ws.labels.push_back({vertex, distance, cost, parent});
+        ws.heap.push_back(static_cast<int>(ws.labels.size()) - 1);
+        std::push_heap(ws.heap.begin(), ws.heap.end(), later);
+    };
+
+    push(origin, 0, 0, -1);
+    while (!ws.heap.empty()) {
+        std::pop_heap(ws.heap.begin(), ws.heap.end(), later);
+        int id = ws.heap.back();
+        ws.heap.pop_back();
+        ParetoWorkspace::Label label = ws.labels[id];
+        int v = label.vertex;
+
+        // Dominated by a settled label here, or cannot beat the cheapest route already found
+        if (label.cost >= ws.bestCost[v]) continue;
+        if (label.cost + ws.lowerCost[v] >= ws.bestCost[destination]) continue;
+        ws.bestCost[v] = label.cost;
+
+        if (v == destination) {
+            frontier.emplace_back();
+            RouteResult& route = frontier.back();
+            route.found = true;
+            route.distance = label.distance;
+            route.cost = label.cost;
+            for (int at = id; at != -1; at = ws.labels[at].parent) route.path.push_back(ws.labels[at].vertex);
+            std::reverse(route.path.begin(), route.path.end());
+            continue;
+        }
+
+        for (int e = g.edgeBegin(v); e < g.edgeEnd(v); ++e) {
+            int w = g.edgeTarget(e);
+            if (ws.stamp[w] != ws.epoch) continue; // Destination unreachable from w
+            int cost = label.cost + g.edgeCost(e);
+            if (cost >= ws.bestCost[w] || cost + ws.lowerCost[w] >= ws.bestCost[destination]) continue;
+            push(w, label.distance + g.edgeDistance(e), cost, id);
+        }
+    }
+    return frontier;
+}
+
+// Returns the cheapest route on the frontier whose distance is within the given stretch of the shortest
+RouteResult cheapestWithinStretch(const std::vector<RouteResult>& frontier, double stretch) {
+    RouteResult best;
+    if (frontier.empty()) return best;
+    double limit = frontier.front().distance * stretch; // Frontier is sorted by distance
+    for (const auto& route : frontier) {
+        if (route.distance > limit) break;
+        best = route; // Later routes on the frontier are longer but cheaper
+    }
+    return best;
+}
@@ -0,0 +1,43 @@
+#ifndef PARETO_H
+#define PARETO_H
+
+#include <cstdint>
+#include <vector>
+#include "routing.h"
+
+class FrozenGraph;
+
+// Reusable per-thread state for (distance, cost) Pareto searches. Labels are allocated from a pool
+// that keeps its capacity between queries, and per-vertex bounds are epoch-stamped like SearchWorkspace.
+class ParetoWorkspace {
+private:
+    struct Label {
+        int vertex;
+        int distance;
+        int cost;
+        int parent; // Label this one was extended from, -1 for the origin
+    };
+
+    std::vector<Label> labels;
+    std::vector<int> heap; // Label ids, min-heap on (distance + bound, cost + bound)
+    std::vector<int> heapDistance;
+    std::vector<int> heapCost;
+    std::vector<uint32_t> stamp;
+    uint32_t epoch = 0;
+    std::vector<int> lowerDistance; // Shortest distance from each vertex to the destination
+    std::vector<int> lowerCost;     // Cheapest cost from each vertex to the destination
+    std::vector<int> bestCost;      // Smallest cost among the labels settled at each vertex
+
+    friend std::vector<RouteResult> paretoRoutes(const FrozenGraph& g, int origin, int destination, ParetoWorkspace& ws);
+
+public:
+    static ParetoWorkspace& local();
+};
+
+// Returns every non-dominated (distance, cost) route from origin to destination, by increasing distance
+std::vector<RouteResult> paretoRoutes(const FrozenGraph& g, int origin, int destination, ParetoWorkspace& ws);
+
+// Returns the cheapest route on the frontier whose distance is within the given stretch (e.g. 1.1) of the shortest
+RouteResult cheapestWithinStretch(const std::vector<RouteResult>& frontier, double stretch);
+
+#endif
@@ -0,0 +1,106 @@
+#include "querycache.h"
+#include <functional>
+
+// QueryKey methods
+bool QueryKey::operator==(const QueryKey& other) const {
+    return kind == other.kind && metric == other.metric && origin == other.origin && destination == other.destination &&
+           hops == other.hops && exactHops == other.exactHops && state == other.state;
+}
+
+// Mixes every key field into one hash
+size_t QueryCache::KeyHash::operator()(const QueryKey& key) const {
+    uint64_t h = static_cast<uint64_t>(key.kind) * 3 + static_cast<uint64_t>(key.metric);
+    for (uint64_t part : {static_cast<uint64_t>(static_cast<uint32_t>(key.origin)), static_cast<uint64_t>(static_cast<uint32_t>(key.destination)),
+                          static_cast<uint64_t>(static_cast<uint32_t>(key.hops)) * 2 + key.exactHops}) {
+        h = (h ^ part) * 0x9E3779B97F4A7C15ULL;
+        h ^= h >> 29;
+    }
+    if (!key.state.empty()) h ^= std::hash<std::string>()(key.state) * 0x9E3779B97F4A7C15ULL;
+    return static_cast<size_t>(h ^ (h >> 32));
+}
+
+// QueryCache methods
+// Creates an empty cache that keeps its entries within roughly memoryBudget bytes
+QueryCache::QueryCache(size_t memoryBudget) : shardBudget(memoryBudget / SHARD_COUNT) {}
+
+// Picks the shard that owns a key
+QueryCache::Shard& QueryCache::shardFor(const QueryKey& key) {
+    return shards[(KeyHash()(key) >> 7) % SHARD_COUNT];
+}
+
+// Removes one entry from a shard (the shard's lock must be held)
+void QueryCache::erase(Shard& shard, std::list<Entry>::iterator entry) {
+    shard.bytes -= entry->bytes;
+    shard.index.erase(entry->key);
+    shard.entries.erase(entry);
+}
+
+// Returns the cached result for a key computed on the given graph version, or nullptr on a miss.
+// A hit moves the entry to the front of its shard's LRU list. Only entries older than the caller's version are
+// dropped: a reader still on an older snapshot misses on a newer entry but leaves it for the readers that want it
+QueryCache::Result QueryCache::find(const QueryKey& key, uint64_t version) {
+    Shard& shard = shardFor(key);
+    std::lock_guard<std::mutex> guard(shard.lock);
+    auto it = shard.index.find(key);
+    if (it == shard.index.end()) {
+        misses.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    if (it->second->version != version) {
+        if (it->second->version < version) { // Computed on an older graph
+            erase(shard, it->second);
+            stale.fetch_add(1, std::memory_order_relaxed);
+        }
+        misses.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+    hits.fetch_add(1, std::memory_order_relaxed);
+    return it->second->routes;
+}
+
+// Stores a result computed on the given graph version, evicting least recently used entries of the shard
+// until it fits the budget. Results larger than a whole shard's budget, or older than the entry already
+// cached for the key, are not cached
+void QueryCache::insert(const QueryKey& key, uint64_t version, std::vector<RouteResult> routes) {
+    size_t bytes = sizeof(Entry) + key.state.capacity() + sizeof(std::vector<RouteResult>) + 64; // Node, map slot and control block
+    for (const auto& route : routes) bytes += sizeof(RouteResult) + route.path.size() * sizeof(int);
+
+    Shard& shard = shardFor(key);
+    if (bytes > shardBudget) return;
+    Result shared = std::make_shared<const std::vector<RouteResult>>(std::move(routes));
+    std::lock_guard<std::mutex> guard(shard.lock);
+    auto it = shard.index.find(key);
+    if (it != shard.index.end()) {
+        if (it->second->version > version) return;
+        erase(shard, it->second);
+    }
+    while (shard.bytes + bytes > shardBudget && !shard.entries.empty()) {
+        erase(shard, std::prev(shard.entries.end()));
+        evictions.fetch_add(1, std::memory_order_relaxed);
+    }
+    shard.entries.push_front({key, version, std::move(shared), bytes});
+    shard.index.emplace(key, shard.entries.begin());
+    shard.bytes += bytes;
+}
+
+// Drops every entry (the counters are kept)
+void QueryCache::clear() {
+    for (Shard& shard : shards) {
+        std::lock_guard<std::mutex> guard(shard.lock);
+        shard.index.clear();
+        shard.entries.clear();
+        shard.bytes = 0;
+    }
+}
+
+// Returns the hit/miss/eviction counters and the current size
+QueryCache::Stats QueryCache::stats() {
+    Stats result = {hits.load(), misses.load(), evictions.load(), stale.load(), 0, 0};
+    for (Shard& shard : shards) {
+        std::lock_guard<std::mutex> guard(shard.lock);
+        result.entries += shard.entries.size();
+        result.bytes += shard.bytes;
+    }
+    return result;
+}
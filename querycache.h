@@ -0,0 +1,91 @@
+#ifndef QUERYCACHE_H
+#define QUERYCACHE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "routing.h"
+
+// Identifies one query: the engine, its metric and every parameter its answer depends on
+struct QueryKey {
+    enum class Kind { Route, RouteWithStops, RoutesToState };
+
+    Kind kind = Kind::Route;
+    Metric metric = Metric::Distance;
+    int origin = 0;
+    int destination = -1; // -1 for state queries
+    int hops = 0;         // Stop limit of stop-limited queries
+    bool exactHops = false;
+    std::string state;    // Target state of state queries
+
+    bool operator==(const QueryKey& other) const;
+};
+
+// Bounded LRU cache of query results, split into independently locked shards so concurrent readers rarely
+// contend. Every entry records the graph version it was computed on; a lookup with a newer version treats it
+// as a miss and drops it, so changing the graph invalidates the whole cache in O(1). A lookup from an older
+// snapshot still being read also misses but keeps the entry. Results are shared,
+// immutable vectors, so a hit costs a hash lookup and a reference count bump.
+class QueryCache {
+public:
+    using Result = std::shared_ptr<const std::vector<RouteResult>>;
+
+    struct Stats {
+        uint64_t hits;
+        uint64_t misses;
+        uint64_t evictions; // Entries dropped to stay within the memory budget
+        uint64_t stale;     // Entries dropped because the graph changed
+        size_t entries;
+        size_t bytes;
+    };
+
+private:
+    static const size_t SHARD_COUNT = 16;
+
+    struct KeyHash {
+        size_t operator()(const QueryKey& key) const;
+    };
+
+    struct Entry {
+        QueryKey key;
+        uint64_t version;
+        Result routes;
+        size_t bytes;
+    };
+
+    struct Shard {
+        std::mutex lock;
+        std::list<Entry> entries; // Most recently used first
+        std::unordered_map<QueryKey, std::list<Entry>::iterator, KeyHash> index;
+        size_t bytes = 0;
+    };
+
+    Shard shards[SHARD_COUNT];
+    size_t shardBudget;
+    std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> misses{0};
+    std::atomic<uint64_t> evictions{0};
+    std::atomic<uint64_t> stale{0};
+
+    Shard& shardFor(const QueryKey& key);
+    void erase(Shard& shard, std::list<Entry>::iterator entry);
+
+public: // See implementation file for details
+    explicit QueryCache(size_t memoryBudget = 64 << 20);
+    QueryCache(const QueryCache&) = delete;
+    QueryCache& operator=(const QueryCache&) = delete;
+
+    Result find(const QueryKey& key, uint64_t version);
+    void insert(const QueryKey& key, uint64_t version, std::vector<RouteResult> routes);
+    void clear();
+    Stats stats();
+    size_t memoryBudget() const { return shardBudget * SHARD_COUNT; }
+};
+
+#endif
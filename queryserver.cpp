@@ -0,0 +1,464 @@
+#include "queryserver.h"
+#include "metrics.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <istream>
+#include <map>
+#include <ostream>
+#include <sstream>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+// Joins a route's airport codes with dashes
+std::string pathText(const FrozenGraph& g, const std::vector<int>& path) {
+    std::string text;
+    for (size_t i = 0; i < path.size(); ++i) {
+        if (i) text += '-';
+        text += g.getAirportCode(path[i]);
+    }
+    return text;
+}
+
+// Formats the reply to a route query
+std::string routeReply(const FrozenGraph& g, const RouteResult& route) {
+    if (!route.found) return "none";
+    return "ok " + std::to_string(route.distance) + " " + std::to_string(route.cost) + " " + pathText(g, route.path);
+}
+
+// Parses an optional metric argument (distance when absent). Returns false for anything else
+bool parseMetric(std::istream& in, Metric& metric) {
+    std::string name;
+    metric = Metric::Distance;
+    if (!(in >> name) || name == "distance") return true;
+    if (name == "cost") {
+        metric = Metric::Cost;
+        return true;
+    }
+    return false;
+}
+
+// Writes all of data to a socket, retrying short writes. Returns false once the peer is gone
+bool sendAll(int fd, const void* data, size_t size) {
+    const char* p = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t written = send(fd, p, size, MSG_NOSIGNAL);
+        if (written < 0 && errno == EINTR) continue;
+        if (written <= 0) return false;
+        p += written;
+        size -= written;
+    }
+    return true;
+}
+
+} // namespace
+
+// SnapshotPublisher methods
+// Creates a publisher for reader ids [0, readerCount) with no snapshot yet
+SnapshotPublisher::SnapshotPublisher(int readerCount) : readers(std::max(1, readerCount)) {}
+
+// Deletes the current snapshot. No reader may still be inside
+SnapshotPublisher::~SnapshotPublisher() {
+    delete current.load();
+}
+
+// Makes next the snapshot every later enter() sees, then deletes the one it replaced once no reader can still be
+// reading it. Readers that entered before the swap recorded an older epoch, so the grace period is over when
+// every slot is either empty or at least the epoch opened after the swap
+void SnapshotPublisher::publish(std::unique_ptr<const FrozenGraph> next) {
+    std::lock_guard<std::mutex> guard(publishLock);
+    const FrozenGraph* old = current.exchange(next.release());
+    uint64_t graceEpoch = epoch.fetch_add(1) + 1;
+    for (ReaderSlot& slot : readers) {
+        for (;;) {
+            uint64_t entered = slot.epoch.load();
+            if (entered == 0 || entered >= graceEpoch) break;
+            std::this_thread::yield();
+        }
+    }
+    delete old;
+}
+
+// Marks the reader as inside and returns the current snapshot, which stays valid until leave(). Never blocks.
+// The slot is written before the pointer is read, so a publisher that swaps afterwards is bound to see it
+const FrozenGraph* SnapshotPublisher::enter(int reader) {
+    readers[reader].epoch.store(epoch.load());
+    return current.load();
+}
+
+// Marks the reader as outside, releasing the snapshot it entered with
+void SnapshotPublisher::leave(int reader) {
+    readers[reader].epoch.store(0, std::memory_order_release);
+}
+
+// QueryServer methods
+// Takes ownership of the graph, publishes its first snapshot and starts the update thread. workerCount is the
+// number of threads that answer queries, 0 meaning one per hardware thread
+QueryServer::QueryServer(Graph graph, int workerCount)
+    : master(std::move(graph)),
+      snapshots(workerCount > 0 ? workerCount : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()))) {
+    snapshots.publish(freezeMaster());
+    updater = std::thread(&QueryServer::updateLoop, this);
+}
+
+// Stops serving, applies the updates still queued and joins the update thread
+QueryServer::~QueryServer() {
+    stop();
+    {
+        std::lock_guard<std::mutex> guard(updateLock);
+        stopping = true;
+    }
+    updateReady.notify_all();
+    updater.join();
+}
+
+// Freezes the update thread's graph into a new snapshot, sharing the graph's query cache if it has one
+std::unique_ptr<FrozenGraph> QueryServer::freezeMaster() const {
+    std::unique_ptr<FrozenGraph> next(new FrozenGraph(master.freeze()));
+    if (master.getQueryCache()) next->attachCache(master.getQueryCache());
+    return next;
+}
+
+// Applies queued updates. Everything queued while the last snapshot was being built goes into the next one, so a
+// burst of updates costs one freeze rather than one per update
+void QueryServer::updateLoop() {
+    for (;;) {
+        std::vector<std::unique_ptr<Update>> batch;
+        {
+            std::unique_lock<std::mutex> guard(updateLock);
+            updateReady.wait(guard, [&] { return stopping || !pendingUpdates.empty(); });
+            if (pendingUpdates.empty()) return;
+            batch.swap(pendingUpdates);
+        }
+
+        std::vector<std::string> replies;
+        bool changed = false;
+        for (auto& update : batch) {
+            bool applied = true;
+            switch (update->kind) {
+            case Update::Kind::Airport:
+                applied = master.getAirportIndex(update->origin) == -1;
+                if (applied) master.addAirport(update->origin, update->dest);
+                replies.push_back(applied ? "" : "error airport " + update->origin + " already exists");
+                break;
+            case Update::Kind::Flight:
+                applied = master.getAirportIndex(update->origin) != -1 && master.getAirportIndex(update->dest) != -1;
+                if (applied) master.addFlight(update->origin, update->dest, update->distance, update->cost);
+                replies.push_back(applied ? "" : "error unknown airport");
+                break;
+            case Update::Kind::Remove:
+                applied = master.removeFlight(update->origin, update->dest);
+                replies.push_back(applied ? "" : "error no flight " + update->origin + "-" + update->dest);
+                break;
+            case Update::Kind::Cost:
+                applied = master.setFlightCost(update->origin, update->dest, update->cost);
+                replies.push_back(applied ? "" : "error no flight " + update->origin + "-" + update->dest);
+                break;
+            }
+            changed = changed || applied;
+        }
+        if (changed) snapshots.publish(freezeMaster());
+
+        std::string published = "ok " + std::to_string(master.getVersion());
+        for (size_t i = 0; i < batch.size(); ++i) {
+            batch[i]->reply.set_value(replies[i].empty() ? published : replies[i]);
+        }
+    }
+}
+
+// Queues an update and waits until it is published (or rejected). Only the submitting worker waits
+std::string QueryServer::submit(std::unique_ptr<Update> update) {
+    std::future<std::string> reply = update->reply.get_future();
+    {
+        std::lock_guard<std::mutex> guard(updateLock);
+        pendingUpdates.push_back(std::move(update));
+    }
+    updateReady.notify_one();
+    return reply.get();
+}
+
+// Answers one text request on behalf of the given worker (0 <= worker < workers()). Queries run against the
+// snapshot current when they start; updates return once they are visible to later queries. A request that throws
+// (running out of memory, say) is answered with an error instead of ending the server
+std::string QueryServer::handle(const std::string& request, int worker) {
+    try {
+        return answer(request, worker);
+    } catch (const std::exception& e) {
+        return std::string("error ") + e.what();
+    } catch (const std::string& message) {
+        return "error " + message;
+    }
+}
+
+// Parses and answers one text request for handle
+std::string QueryServer::answer(const std::string& request, int worker) {
+    std::istringstream in(request);
+    std::string command;
+    if (!(in >> command)) return "error empty request";
+
+    if (command == "route" || command == "stops" || command == "routes" || command == "state" || command == "index") {
+        SnapshotGuard guard(snapshots, worker);
+        const FrozenGraph& g = guard.graph();
+        std::string origin, target;
+        in >> origin;
+        int o = g.getAirportIndex(origin);
+        if (o == -1) return "error unknown airport " + origin;
+        if (command == "index") return "ok " + std::to_string(o);
+
+        in >> target;
+        Metric metric;
+        if (command == "route") {
+            int d = g.getAirportIndex(target);
+            if (d == -1) return "error unknown airport " + target;
+            if (!parseMetric(in, metric)) return "error bad metric";
+            return routeReply(g, g.shortestRoute(o, d, metric));
+        }
+        if (command == "stops") {
+            int d = g.getAirportIndex(target);
+            int stops;
+            std::string exact;
+            if (d == -1) return "error unknown airport " + target;
+            if (!(in >> stops) || stops < 0) return "error bad stop count";
+            in >> exact;
+            if (exact == "exact" && stops > g.maxExactStops()) {
+                return "error too many stops (at most " + std::to_string(g.maxExactStops()) + " for an exact count)";
+            }
+            return routeReply(g, g.shortestRouteWithStops(o, d, stops, exact == "exact"));
+        }
+        if (command == "routes") {
+            int d = g.getAirportIndex(target);
+            int k;
+            if (d == -1) return "error unknown airport " + target;
+            if (!(in >> k) || k < 1 || k > MAX_ROUTE_COUNT) return "error bad route count";
+            if (!parseMetric(in, metric)) return "error bad metric";
+            std::vector<RouteResult> routes = g.kShortestRoutes(o, d, k, metric);
+            std::string reply = "ok " + std::to_string(routes.size());
+            for (const RouteResult& route : routes) {
+                reply += " " + std::to_string(route.distance) + ":" + std::to_string(route.cost) + ":" + pathText(g, route.path);
+            }
+            return reply;
+        }
+        if (!parseMetric(in, metric)) return "error bad metric";
+        std::vector<RouteResult> routes = g.shortestRoutesToState(o, target, metric);
+        std::string reply = "ok " + std::to_string(routes.size());
+        for (const RouteResult& route : routes) {
+            reply += " " + g.getAirportCode(route.path.back()) + ":" + std::to_string(route.distance) + ":" + std::to_string(route.cost);
+        }
+        return reply;
+    }
+
+    std::unique_ptr<Update> update(new Update());
+    if (command == "airport") {
+        update->kind = Update::Kind::Airport;
+        if (!(in >> update->origin >> update->dest)) return "error usage: airport CODE STATE";
+        if (update->origin.size() > 0xFF) return "error airport code longer than 255 characters";
+    } else if (command == "flight") {
+        update->kind = Update::Kind::Flight;
+        if (!(in >> update->origin >> update->dest >> update->distance >> update->cost)) {
+            return "error usage: flight ORIGIN DEST DISTANCE COST";
+        }
+        if (update->distance < 0 || update->cost < 0) return "error distance and cost must be non-negative";
+    } else if (command == "remove") {
+        update->kind = Update::Kind::Remove;
+        if (!(in >> update->origin >> update->dest)) return "error usage: remove ORIGIN DEST";
+    } else if (command == "cost") {
+        update->kind = Update::Kind::Cost;
+        if (!(in >> update->origin >> update->dest >> update->cost)) return "error usage: cost ORIGIN DEST COST";
+        if (update->cost < 0) return "error cost must be non-negative";
+    } else if (command == "version") {
+        SnapshotGuard guard(snapshots, worker);
+        return "ok " + std::to_string(guard.graph().getVersion());
+    } else if (command == "metrics") {
+        return QueryMetrics::global().toJson();
+    } else {
+        return "error unknown command " + command;
+    }
+    return submit(std::move(update));
+}
+
+// Answers one binary request, replacing reply with a BinaryReply header followed by the route's vertex indices.
+// Bad requests, and requests that throw, get status -1
+void QueryServer::handleBinary(const BinaryRequest& request, int worker, std::vector<int32_t>& reply) {
+    try {
+        answerBinary(request, worker, reply);
+    } catch (...) {
+        reply.assign(4, 0);
+        reply[0] = -1;
+    }
+}
+
+// Answers one binary request for handleBinary
+void QueryServer::answerBinary(const BinaryRequest& request, int worker, std::vector<int32_t>& reply) {
+    reply.assign(4, 0);
+    SnapshotGuard guard(snapshots, worker);
+    const FrozenGraph& g = guard.graph();
+    int n = g.vertexCount();
+    if ((request.op != 1 && request.op != 2) || request.metric > 1 || request.origin < 0 || request.origin >= n ||
+        request.destination < 0 || request.destination >= n) {
+        reply[0] = -1;
+        return;
+    }
+
+    RouteResult route;
+    if (request.op == 1) {
+        route = g.shortestRoute(request.origin, request.destination, request.metric ? Metric::Cost : Metric::Distance);
+    } else {
+        route = g.shortestRouteWithStops(request.origin, request.destination, request.stops, false,
+                                         request.metric ? Metric::Cost : Metric::Distance);
+    }
+    reply[0] = route.found ? 1 : 0;
+    reply[1] = route.distance;
+    reply[2] = route.cost;
+    reply[3] = static_cast<int32_t>(route.path.size());
+    reply.insert(reply.end(), route.path.begin(), route.path.end());
+}
+
+// Answers newline-delimited requests from in until it ends, writing one reply line per request to out in request
+// order. Requests are answered in parallel by the workers, so a query sent right after an update may run before
+// the update is published; wait for the update's reply first when the order matters
+void QueryServer::serveStream(std::istream& in, std::ostream& out) {
+    std::mutex lock;
+    std::condition_variable changed;
+    std::deque<std::pair<uint64_t, std::string>> requests;
+    std::map<uint64_t, std::string> replies; // Finished out of order, waiting for earlier ones
+    uint64_t nextReply = 0;
+    bool ended = false;
+    const size_t queueLimit = 64 * workers(); // Bounds memory when input arrives faster than it is answered
+
+    std::vector<std::thread> threads;
+    for (int w = 0; w < workers(); ++w) {
+        threads.emplace_back([&, w] {
+            for (;;) {
+                std::pair<uint64_t, std::string> request;
+                {
+                    std::unique_lock<std::mutex> guard(lock);
+                    changed.wait(guard, [&] { return ended || !requests.empty(); });
+                    if (requests.empty()) return;
+                    request = std::move(requests.front());
+                    requests.pop_front();
+                }
+                changed.notify_all();
+                std::string reply = handle(request.second, w);
+
+                std::lock_guard<std::mutex> guard(lock);
+                replies[request.first] = std::move(reply);
+                bool wrote = false;
+                for (auto it = replies.begin(); it != replies.end() && it->first == nextReply; it = replies.erase(it)) {
+                    out << it->second << '\n';
+                    nextReply++;
+                    wrote = true;
+                }
+                if (wrote) out.flush();
+            }
+        });
+    }
+
+    std::string line;
+    for (uint64_t sequence = 0; std::getline(in, line);) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.find_first_not_of(" \t") == std::string::npos) continue;
+        std::unique_lock<std::mutex> guard(lock);
+        changed.wait(guard, [&] { return requests.size() < queueLimit; });
+        requests.emplace_back(sequence++, std::move(line));
+        guard.unlock();
+        changed.notify_all();
+    }
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        ended = true;
+    }
+    changed.notify_all();
+    for (auto& thread : threads) thread.join();
+}
+
+// Serves one socket connection until the client closes it: text lines, or binary frames if its first byte is
+// BINARY_MAGIC
+void QueryServer::serveConnection(int fd, int worker) {
+    std::string buffer;
+    char chunk[4096];
+    bool binary = false, decided = false;
+    std::vector<int32_t> reply;
+    for (;;) {
+        ssize_t got = recv(fd, chunk, sizeof(chunk), 0);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) return;
+        buffer.append(chunk, got);
+        if (!decided) {
+            binary = static_cast<unsigned char>(buffer[0]) == BINARY_MAGIC;
+            if (binary) buffer.erase(0, 1);
+            decided = true;
+        }
+
+        size_t used = 0;
+        if (binary) {
+            for (; buffer.size() - used >= sizeof(BinaryRequest); used += sizeof(BinaryRequest)) {
+                BinaryRequest request;
+                std::memcpy(&request, buffer.data() + used, sizeof(request));
+                handleBinary(request, worker, reply);
+                if (!sendAll(fd, reply.data(), reply.size() * sizeof(int32_t))) return;
+            }
+        } else {
+            for (size_t newline; (newline = buffer.find('\n', used)) != std::string::npos; used = newline + 1) {
+                std::string line = buffer.substr(used, newline - used);
+                if (!line.empty() && line.back() == '\r') line.pop_back();
+                if (line == "quit") return;
+                if (line.find_first_not_of(" \t") == std::string::npos) continue;
+                std::string text = handle(line, worker) + "\n";
+                if (!sendAll(fd, text.data(), text.size())) return;
+            }
+        }
+        buffer.erase(0, used);
+    }
+}
+
+// Listens on a Unix domain socket at path (replacing any stale socket file) and serves connections until stop().
+// Each worker accepts and serves one connection at a time. Returns false if the socket could not be set up
+bool QueryServer::serveSocket(const std::string& path) {
+    sockaddr_un address{};
+    if (path.size() >= sizeof(address.sun_path)) return false;
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return false;
+    unlink(path.c_str());
+    if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(fd, 128) != 0) {
+        close(fd);
+        return false;
+    }
+    listenFd = fd;
+    listening = true;
+
+    std::vector<std::thread> threads;
+    for (int w = 0; w < workers(); ++w) {
+        threads.emplace_back([this, fd, w] {
+            while (listening) {
+                int client = accept(fd, nullptr, nullptr);
+                if (client < 0) {
+                    if (errno == EINTR || errno == ECONNABORTED) continue;
+                    break;
+                }
+                serveConnection(client, w);
+                close(client);
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    listenFd = -1;
+    close(fd);
+    unlink(path.c_str());
+    return true;
+}
+
+// Makes serveSocket stop accepting and return once open connections close. Only touches atomics and the
+// listening socket, so it is safe to call from a signal handler
+void QueryServer::stop() {
+    listening = false;
+    int fd = listenFd.load();
+    if (fd >= 0) shutdown(fd, SHUT_RDWR);
+}
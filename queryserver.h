@@ -0,0 +1,138 @@
+#ifndef QUERYSERVER_H
+#define QUERYSERVER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <future>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "graph.h"
+
+// Publishes immutable graph snapshots to a fixed set of reader threads, RCU style. A reader records the epoch it
+// enters in, loads the current snapshot pointer and reads through it with no locks or reference counts.
+// publish() swaps the pointer atomically, then waits out a grace period (every reader has left, or entered
+// after the swap) before deleting the old snapshot. Readers never wait; only the publisher does.
+class SnapshotPublisher {
+private:
+    struct alignas(64) ReaderSlot { // One cache line per reader, so entering never shares a line
+        std::atomic<uint64_t> epoch{0}; // Epoch the reader entered in, 0 while it is outside
+    };
+
+    std::atomic<const FrozenGraph*> current{nullptr};
+    std::atomic<uint64_t> epoch{1};
+    std::vector<ReaderSlot> readers;
+    std::mutex publishLock; // One publisher at a time
+
+public: // See implementation file for details
+    explicit SnapshotPublisher(int readerCount);
+    SnapshotPublisher(const SnapshotPublisher&) = delete;
+    SnapshotPublisher& operator=(const SnapshotPublisher&) = delete;
+    ~SnapshotPublisher();
+
+    int readerCount() const { return static_cast<int>(readers.size()); }
+    void publish(std::unique_ptr<const FrozenGraph> next);
+    const FrozenGraph* enter(int reader);
+    void leave(int reader);
+};
+
+// Keeps one reader inside a SnapshotPublisher for its lifetime; the snapshot stays valid until then
+class SnapshotGuard {
+private:
+    SnapshotPublisher& publisher;
+    int reader;
+    const FrozenGraph* snapshot;
+
+public:
+    SnapshotGuard(SnapshotPublisher& publisher, int reader) : publisher(publisher), reader(reader), snapshot(publisher.enter(reader)) {}
+    SnapshotGuard(const SnapshotGuard&) = delete;
+    SnapshotGuard& operator=(const SnapshotGuard&) = delete;
+    ~SnapshotGuard() { publisher.leave(reader); }
+
+    const FrozenGraph& graph() const { return *snapshot; }
+};
+
+// Long-running query server. The graph is loaded once; worker threads answer queries against the published
+// snapshot, and schedule updates go to a single update thread that applies each burst of them to its private
+// Graph, freezes it and publishes the result. A reply to an update is sent once the update is visible.
+//
+// Text protocol, one request and one reply line each (codes are airport codes, metric is distance or cost):
+//   route ORIG DEST [metric]         ok DIST COST ORIG-...-DEST | none
+//   stops ORIG DEST N [exact]        same, with at most (or exactly) N stops (exact N up to the graph's maxExactStops)
+//   routes ORIG DEST K [metric]      ok COUNT DIST:COST:ORIG-...-DEST ... (the K <= MAX_ROUTE_COUNT shortest loopless routes)
+//   state ORIG ST [metric]           ok COUNT DEST:DIST:COST ...
+//   index CODE                       ok INDEX (indices never change, so binary clients can cache them)
+//   airport CODE ST | flight ORIG DEST DIST COST | remove ORIG DEST | cost ORIG DEST COST
+//                                    ok VERSION once the update is published (DIST and COST non-negative)
+//   version | metrics                ok VERSION | the query metrics as JSON
+// Failures reply "error MESSAGE", including a query that throws, so one bad request never stops the server. A socket connection whose first byte is BINARY_MAGIC speaks the binary
+// protocol instead: fixed BinaryRequest frames answered by a BinaryReply header plus hops vertex indices.
+class QueryServer {
+public:
+    static const unsigned char BINARY_MAGIC = 0xB1;
+    static const int MAX_ROUTE_COUNT = 100; // Bounds the spur searches one routes request can run
+
+    struct BinaryRequest {
+        uint8_t op;       // 1 = route, 2 = route with at most stops stops
+        uint8_t metric;   // 0 = distance, 1 = cost
+        uint16_t stops;
+        int32_t origin;   // Airport indices
+        int32_t destination;
+        int32_t reserved;
+    };
+
+    struct BinaryReply {
+        int32_t status;   // 1 = found, 0 = no route, -1 = bad request
+        int32_t distance;
+        int32_t cost;
+        int32_t hops;     // Number of vertex indices following the header
+    };
+
+private:
+    struct Update {
+        enum class Kind { Airport, Flight, Remove, Cost } kind;
+        std::string origin; // Airport: the code
+        std::string dest;   // Airport: the state
+        int distance = 0;
+        int cost = 0;
+        std::promise<std::string> reply;
+    };
+
+    Graph master; // Touched only by the update thread once the server is running
+    SnapshotPublisher snapshots;
+
+    std::mutex updateLock;
+    std::condition_variable updateReady;
+    std::vector<std::unique_ptr<Update>> pendingUpdates;
+    bool stopping = false;
+    std::thread updater;
+
+    std::atomic<bool> listening{false};
+    std::atomic<int> listenFd{-1};
+
+    void updateLoop();
+    std::unique_ptr<FrozenGraph> freezeMaster() const;
+    std::string submit(std::unique_ptr<Update> update);
+    std::string answer(const std::string& request, int worker);
+    void answerBinary(const BinaryRequest& request, int worker, std::vector<int32_t>& reply);
+    void serveConnection(int fd, int worker);
+
+public: // See implementation file for details
+    explicit QueryServer(Graph graph, int workerCount = 0);
+    QueryServer(const QueryServer&) = delete;
+    QueryServer& operator=(const QueryServer&) = delete;
+    ~QueryServer();
+
+    int workers() const { return snapshots.readerCount(); }
+    std::string handle(const std::string& request, int worker);
+    void handleBinary(const BinaryRequest& request, int worker, std::vector<int32_t>& reply);
+    void serveStream(std::istream& in, std::ostream& out);
+    bool serveSocket(const std::string& path);
+    void stop();
+};
+
+#endif
@@ -0,0 +1,386 @@
+#include "routing.h"
+#include "frozengraph.h"
+#include <algorithm>
+#include <limits>
+
+// SearchWorkspace methods
+// Returns one of this thread's workspaces (slot 0 or 1)
+SearchWorkspace& SearchWorkspace::local(int slot) {
+    thread_local SearchWorkspace workspaces[2];
+    return workspaces[slot];
+}
+
+// Starts a new query: grows the label arrays if needed and invalidates every old label in O(1)
+void SearchWorkspace::begin(int vertexCount) {
+    if (stamp.size() < vertexCount) {
+        stamp.resize(vertexCount, 0);
+        keys.resize(vertexCount);
+        distances.resize(vertexCount);
+        costs.resize(vertexCount);
+        parents.resize(vertexCount);
+        heapPos.resize(vertexCount);
+        heap.reserve(vertexCount); // The queue never holds more, so pushes never reallocate
+        growths++;
+    }
+    if (++epoch == 0) { // Stamp counter wrapped; old stamps could look current again
+        std::fill(stamp.begin(), stamp.end(), 0);
+        epoch = 1;
+    }
+    heap.clear();
+    popped = 0;
+}
+
+// Labels v with the given route if it has not been reached yet or the key strictly improves. Returns whether it did
+bool SearchWorkspace::improve(int v, int key, int distance, int cost, int parent) {
+    if (!reached(v)) {
+        stamp[v] = epoch;
+        heapPos[v] = static_cast<int>(heap.size());
+        heap.push_back(v);
+    } else if (heapPos[v] == SETTLED || key >= keys[v]) {
+        return false;
+    }
+    keys[v] = key;
+    distances[v] = distance;
+    costs[v] = cost;
+    parents[v] = parent;
+    siftUp(heapPos[v]);
+    return true;
+}
+
+// Removes and returns the queued vertex with the smallest key, marking it settled
+int SearchWorkspace::popMin() {
+    int top = heap.front();
+    heapPos[top] = SETTLED;
+    popped++;
+    int last = heap.back();
+    heap.pop_back();
+    if (!heap.empty()) {
+        heap[0] = last;
+        heapPos[last] = 0;
+        siftDown(0);
+    }
+    return top;
+}
+
+// Moves the heap entry at i towards the root until its parent is smaller
+void SearchWorkspace::siftUp(int i) {
+    int v = heap[i];
+    while (i > 0) {
+        int p = (i - 1) / 4;
+        if (!heapLess(v, heap[p])) break;
+        heap[i] = heap[p];
+        heapPos[heap[i]] = i;
+        i = p;
+    }
+    heap[i] = v;
+    heapPos[v] = i;
+}
+
+// Moves the heap entry at i towards the leaves until all of its children are larger
+void SearchWorkspace::siftDown(int i) {
+    int v = heap[i];
+    int n = static_cast<int>(heap.size());
+    while (true) {
+        int first = 4 * i + 1;
+        if (first >= n) break;
+        int best = first;
+        int last = std::min(first + 4, n);
+        for (int c = first + 1; c < last; ++c) {
+            if (heapLess(heap[c], heap[best])) best = c;
+        }
+        if (!heapLess(heap[best], v)) break;
+        heap[i] = heap[best];
+        heapPos[heap[i]] = i;
+        i = best;
+    }
+    heap[i] = v;
+    heapPos[v] = i;
+}
+
+// HopLayers methods
+// Returns this thread's hop layers
+HopLayers& HopLayers::local() {
+    thread_local HopLayers layers;
+    return layers;
+}
+
+// Starts a new hop-limited query with layers 0..maxHops, invalidating every old label in O(1)
+void HopLayers::begin(int vertices, int maxHops) {
+    vertexCount = vertices;
+    layerCount = maxHops + 1;
+    size_t slots = static_cast<size_t>(vertexCount) * layerCount;
+    if (stamp.size() < slots) {
+        stamp.resize(slots, 0);
+        keys.resize(slots);
+        distances.resize(slots);
+        costs.resize(slots);
+        parents.resize(slots);
+        growths++;
+    }
+    if (++epoch == 0) { // Stamp counter wrapped; old stamps could look current again
+        std::fill(stamp.begin(), stamp.end(), 0);
+        epoch = 1;
+    }
+    if (frontiers.size() < layerCount) frontiers.resize(layerCount);
+    for (int h = 0; h < layerCount; ++h) frontiers[h].clear();
+}
+
+// Returns the hop count in [minHops, maxHops] with the smallest key at v, or -1 if v is never reached
+int HopLayers::bestHops(int v, int minHops) const {
+    int best = -1;
+    for (int h = minHops; h < layerCount; ++h) {
+        if (reached(h, v) && (best == -1 || key(h, v) < key(best, v))) best = h;
+    }
+    return best;
+}
+
+// Query engines
+// Dijkstra loop shared by every variant; Backward walks the inbound CSR so labels hold distances to source.
+// The search ends early once stop(u) returns true for a settled vertex u. Given a goal vertex, it never
+// enters components the connectivity index rules out of every route between source and goal
+template <Direction D, typename Probe, typename Stop>
+static void runDijkstra(const FrozenGraph& g, int source, int goal, SearchWorkspace& ws, Metric metric, Probe& probe, Stop&& stop) {
+    auto leadsToGoal = [&](int v) {
+        return goal < 0 || ((D == Direction::Forward) ? g.mayReach(v, goal) : g.mayReach(goal, v));
+    };
+    int growths = ws.growthCount();
+    ws.begin(g.vertexCount());
+    probe.allocate(ws.growthCount() - growths);
+    ws.improve(source, 0, 0, 0, -1, probe);
+    if (!leadsToGoal(source)) return;
+    while (!ws.empty()) {
+        int u = ws.popMin();
+        probe.settle();
+        if (stop(u)) break;
+
+        int key = ws.key(u), distance = ws.distance(u), cost = ws.cost(u);
+        int begin = (D == Direction::Forward) ? g.edgeBegin(u) : g.reverseBegin(u);
+        int end = (D == Direction::Forward) ? g.edgeEnd(u) : g.reverseEnd(u);
+        for (int e = begin; e < end; ++e) {
+            int v = (D == Direction::Forward) ? g.edgeTarget(e) : g.reverseSource(e);
+            if (!leadsToGoal(v)) continue;
+            int edgeDistance = (D == Direction::Forward) ? g.edgeDistance(e) : g.reverseDistance(e);
+            int edgeCost = (D == Direction::Forward) ? g.edgeCost(e) : g.reverseCost(e);
+            int weight = (metric == Metric::Distance) ? edgeDistance : edgeCost;
+            ws.improve(v, key + weight, distance + edgeDistance, cost + edgeCost, u, probe);
+        }
+    }
+}
+
+// Runs runDijkstra in the direction asked for, counting into stats only when given some
+template <typename Stop>
+static void runDijkstra(const FrozenGraph& g, int source, int goal, SearchWorkspace& ws, Metric metric, Direction direction,
+                        SearchStats* stats, Stop&& stop) {
+    NoProbe silent;
+    if (stats) {
+        CountingProbe counting{*stats};
+        if (direction == Direction::Forward) {
+            runDijkstra<Direction::Forward>(g, source, goal, ws, metric, counting, stop);
+        } else {
+            runDijkstra<Direction::Backward>(g, source, goal, ws, metric, counting, stop);
+        }
+    } else if (direction == Direction::Forward) {
+        runDijkstra<Direction::Forward>(g, source, goal, ws, metric, silent, stop);
+    } else {
+        runDijkstra<Direction::Backward>(g, source, goal, ws, metric, silent, stop);
+    }
+}
+
+// Single-source Dijkstra from source, stopping as soon as target is settled (pass -1 to settle everything reachable).
+// A Backward search follows flights in reverse, so parents point towards the source instead of away from it
+void dijkstra(const FrozenGraph& g, int source, int target, SearchWorkspace& ws, Metric metric, Direction direction,
+              SearchStats* stats) {
+    runDijkstra(g, source, target, ws, metric, direction, stats, [target](int u) { return u == target; });
+}
+
+// Single-source Dijkstra from source that stops as soon as every vertex in targets is settled (or unreachable)
+void dijkstraToTargets(const FrozenGraph& g, int source, const std::vector<int>& targets, SearchWorkspace& ws, Metric metric,
+                       SearchStats* stats) {
+    thread_local std::vector<char> isTarget;
+    if (isTarget.size() < g.vertexCount()) isTarget.resize(g.vertexCount(), 0);
+    int remaining = 0;
+    for (int t : targets) {
+        if (!isTarget[t]) remaining++;
+        isTarget[t] = 1;
+    }
+    runDijkstra(g, source, -1, ws, metric, Direction::Forward, stats, [&](int u) { return isTarget[u] && --remaining == 0; });
+    for (int t : targets) isTarget[t] = 0;
+}
+
+// Copies the route to destination out of a finished search. Reuses the result's path storage; returns whether a route exists
+bool extractRoute(const SearchWorkspace& ws, int destination, RouteResult& result) {
+    result.path.clear();
+    result.found = ws.reached(destination);
+    if (!result.found) return false;
+
+    // Count hops first so the path is written back to front without shifting
+    int hops = 0;
+    for (int at = destination; at != -1; at = ws.parent(at)) ++hops;
+    result.path.resize(hops);
+    for (int at = destination; at != -1; at = ws.parent(at)) result.path[--hops] = at;
+
+    result.distance = ws.distance(destination);
+    result.cost = ws.cost(destination);
+    return true;
+}
+
+// Expands the next vertex of one frontier of a bidirectional search, recording any better meeting point
+template <Direction D, typename Probe>
+static void expandFrontier(const FrozenGraph& g, int source, int target, SearchWorkspace& ws, const SearchWorkspace& other,
+                           Metric metric, long long& best, int& meet, Probe& probe) {
+    int u = ws.popMin();
+    probe.settle();
+    int key = ws.key(u), distance = ws.distance(u), cost = ws.cost(u);
+    if (other.reached(u) && key + (long long)other.key(u) < best) {
+        best = key + (long long)other.key(u);
+        meet = u;
+    }
+    int begin = (D == Direction::Forward) ? g.edgeBegin(u) : g.reverseBegin(u);
+    int end = (D == Direction::Forward) ? g.edgeEnd(u) : g.reverseEnd(u);
+    for (int e = begin; e < end; ++e) {
+        int v = (D == Direction::Forward) ? g.edgeTarget(e) : g.reverseSource(e);
+        if ((D == Direction::Forward) ? !g.mayReach(v, target) : !g.mayReach(source, v)) continue;
+        int edgeDistance = (D == Direction::Forward) ? g.edgeDistance(e) : g.reverseDistance(e);
+        int edgeCost = (D == Direction::Forward) ? g.edgeCost(e) : g.reverseCost(e);
+        int weight = (metric == Metric::Distance) ? edgeDistance : edgeCost;
+        ws.improve(v, key + weight, distance + edgeDistance, cost + edgeCost, u, probe);
+        if (other.reached(v) && ws.key(v) + (long long)other.key(v) < best) {
+            best = ws.key(v) + (long long)other.key(v);
+            meet = v;
+        }
+    }
+}
+
+// Bidirectional Dijkstra between source and target, needing no preprocessing: the forward frontier follows outbound
+// flights from the source and the backward frontier follows inbound flights into the target, taking turns. It stops
+// once the two smallest queued keys add up to at least the best route seen through any vertex labelled by both.
+// Returns whether a route exists; the labels stay in the two workspaces
+template <typename Probe>
+static bool runBidirectional(const FrozenGraph& g, int source, int target, SearchWorkspace& forward, SearchWorkspace& backward,
+                             RouteResult& result, Metric metric, Probe& probe) {
+    result.path.clear();
+    result.found = false;
+    int growths = forward.growthCount() + backward.growthCount();
+    forward.begin(g.vertexCount());
+    backward.begin(g.vertexCount());
+    probe.allocate(forward.growthCount() + backward.growthCount() - growths);
+    if (!g.mayReach(source, target)) return false;
+    forward.improve(source, 0, 0, 0, -1, probe);
+    backward.improve(target, 0, 0, 0, -1, probe);
+
+    long long best = std::numeric_limits<long long>::max();
+    int meet = -1;
+    bool forwardTurn = true;
+    while (!forward.empty() && !backward.empty()) {
+        if ((long long)forward.minKey() + backward.minKey() >= best) break;
+        if (forwardTurn) {
+            expandFrontier<Direction::Forward>(g, source, target, forward, backward, metric, best, meet, probe);
+        } else {
+            expandFrontier<Direction::Backward>(g, source, target, backward, forward, metric, best, meet, probe);
+        }
+        forwardTurn = !forwardTurn;
+    }
+    if (meet == -1) return false;
+
+    // Source -> meet from the forward parents, then meet -> target from the backward ones
+    for (int at = meet; at != -1; at = forward.parent(at)) result.path.push_back(at);
+    std::reverse(result.path.begin(), result.path.end());
+    for (int at = backward.parent(meet); at != -1; at = backward.parent(at)) result.path.push_back(at);
+    result.found = true;
+    result.distance = forward.distance(meet) + backward.distance(meet);
+    result.cost = forward.cost(meet) + backward.cost(meet);
+    return true;
+}
+
+// Bidirectional Dijkstra entry point; counts into stats only when given some
+bool bidirectionalDijkstra(const FrozenGraph& g, int source, int target, SearchWorkspace& forward, SearchWorkspace& backward,
+                           RouteResult& result, Metric metric, SearchStats* stats) {
+    if (stats) {
+        CountingProbe counting{*stats};
+        return runBidirectional(g, source, target, forward, backward, result, metric, counting);
+    }
+    NoProbe silent;
+    return runBidirectional(g, source, target, forward, backward, result, metric, silent);
+}
+
+// Hop-layered Bellman-Ford from source: one relaxation round per flight, O(maxHops * E) time and O(maxHops * V) labels.
+// Routes may revisit airports, matching the walk semantics of the stop-limited query. Given a target, airports
+// the connectivity index says cannot reach it are never labelled. The probe's queue size is the frontier size
+template <typename Probe>
+void runHopLimitedSearch(const FrozenGraph& g, int source, int maxHops, HopLayers& layers, Metric metric, int target, Probe& probe) {
+    int n = g.vertexCount();
+    int growths = layers.growths;
+    layers.begin(n, maxHops);
+    probe.allocate(layers.growths - growths);
+    probe.push();
+    layers.stamp[source] = layers.epoch;
+    layers.keys[source] = 0;
+    layers.distances[source] = 0;
+    layers.costs[source] = 0;
+    layers.parents[source] = -1;
+    layers.frontiers[0].push_back(source);
+
+    for (int h = 1; h <= maxHops; ++h) {
+        size_t from = static_cast<size_t>(h - 1) * n;
+        size_t to = static_cast<size_t>(h) * n;
+        std::vector<int>& next = layers.frontiers[h];
+
+        // Relax every edge leaving a vertex reached in the previous layer
+        for (int u : layers.frontiers[h - 1]) {
+            probe.settle();
+            int key = layers.keys[from + u], distance = layers.distances[from + u], cost = layers.costs[from + u];
+            for (int e = g.edgeBegin(u); e < g.edgeEnd(u); ++e) {
+                int v = g.edgeTarget(e);
+                if (target >= 0 && !g.mayReach(v, target)) continue;
+                probe.relax();
+                int alt = key + ((metric == Metric::Distance) ? g.edgeDistance(e) : g.edgeCost(e));
+                size_t slot = to + v;
+                if (layers.stamp[slot] != layers.epoch) {
+                    layers.stamp[slot] = layers.epoch;
+                    next.push_back(v);
+                    probe.push();
+                } else if (alt >= layers.keys[slot]) {
+                    continue;
+                } else {
+                    probe.decreaseKey();
+                }
+                layers.keys[slot] = alt;
+                layers.distances[slot] = distance + g.edgeDistance(e);
+                layers.costs[slot] = cost + g.edgeCost(e);
+                layers.parents[slot] = u;
+            }
+        }
+        probe.queueSize(static_cast<int>(next.size()));
+        if (next.empty()) break; // Nothing left to extend
+    }
+}
+
+// Hop-limited search entry point; counts into stats only when given some
+void hopLimitedSearch(const FrozenGraph& g, int source, int maxHops, HopLayers& layers, Metric metric, int target,
+                      SearchStats* stats) {
+    if (stats) {
+        CountingProbe counting{*stats};
+        runHopLimitedSearch(g, source, maxHops, layers, metric, target, counting);
+    } else {
+        NoProbe silent;
+        runHopLimitedSearch(g, source, maxHops, layers, metric, target, silent);
+    }
+}
+
+// Copies the route to destination using exactly the given number of flights out of a finished hop-limited search
+bool extractHopRoute(const HopLayers& layers, int destination, int hops, RouteResult& result) {
+    result.path.clear();
+    result.found = hops >= 0 && hops <= layers.maxHops() && layers.reached(hops, destination);
+    if (!result.found) return false;
+
+    size_t n = layers.vertexCount;
+    result.path.resize(hops + 1);
+    int at = destination;
+    for (int h = hops; h >= 0; --h) {
+        result.path[h] = at;
+        at = layers.parents[h * n + at];
+    }
+    result.distance = layers.distances[hops * n + destination];
+    result.cost = layers.costs[hops * n + destination];
+    return true;
+}
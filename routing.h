@@ -0,0 +1,162 @@
+#ifndef ROUTING_H
+#define ROUTING_H
+
+#include <cstdint>
+#include <vector>
+
+class FrozenGraph;
+
+// Edge weight a search minimizes
+enum class Metric { Distance, Cost };
+
+// Whether a search follows flights forwards from its source or backwards into it
+enum class Direction { Forward, Backward };
+
+// Route returned by the query engines
+struct RouteResult {
+    bool found = false;
+    std::vector<int> path; // Vertex indices from origin to destination
+    int distance = 0;
+    int cost = 0;
+};
+
+// Work done by one query, for comparing engines and explaining slow queries. Engines add to it, so one
+// SearchStats can total every search a query runs
+struct SearchStats {
+    int settled = 0;      // Vertices taken off the priority queue (or expanded, in hop-limited searches)
+    int relaxed = 0;      // Flights examined
+    int pushes = 0;       // Vertices first labelled
+    int decreaseKeys = 0; // Labels improved after being queued
+    int queuePeak = 0;    // Largest priority queue or hop frontier seen
+    int allocations = 0;  // Workspace buffer growths
+    long long wallNs = 0; // Wall time of the whole query, filled in by the query entry points
+};
+
+// Instrumentation policies for the search loops. Each engine is compiled once with NoProbe, whose hooks are
+// empty and vanish, and once with CountingProbe, which tallies into a SearchStats. Entry points taking a
+// SearchStats* run the counting build only when given one, so uninstrumented queries pay nothing
+struct NoProbe {
+    void settle() {}
+    void relax() {}
+    void push() {}
+    void decreaseKey() {}
+    void queueSize(int) {}
+    void allocate(int) {}
+};
+
+struct CountingProbe {
+    SearchStats& stats;
+
+    void settle() { stats.settled++; }
+    void relax() { stats.relaxed++; }
+    void push() { stats.pushes++; }
+    void decreaseKey() { stats.decreaseKeys++; }
+    void queueSize(int size) { stats.queuePeak = (size > stats.queuePeak) ? size : stats.queuePeak; }
+    void allocate(int count) { stats.allocations += count; }
+};
+
+// Reusable per-thread search state (two slots per thread, for searches that run a forward and a backward
+// frontier at once). Per-vertex labels are epoch-stamped, so starting a new query
+// is O(1) and repeated queries on the same graph allocate nothing. The priority queue is a 4-ary
+// min-heap with decrease-key, ordered by (key, vertex index) so ties settle lowest index first.
+class SearchWorkspace {
+private:
+    static const int NOT_QUEUED = -1;
+    static const int SETTLED = -2;
+
+    std::vector<uint32_t> stamp; // Label of v is valid only while stamp[v] == epoch
+    uint32_t epoch = 0;
+    std::vector<int> keys;
+    std::vector<int> distances;
+    std::vector<int> costs;
+    std::vector<int> parents; // Previous vertex on the best known route, -1 for the origin
+    std::vector<int> heapPos; // Index into heap, NOT_QUEUED or SETTLED
+    std::vector<int> heap;
+    int popped = 0; // Vertices settled since begin()
+    int growths = 0; // Times begin() had to grow the buffers
+
+    void siftUp(int i);
+    void siftDown(int i);
+    bool heapLess(int a, int b) const { return keys[a] < keys[b] || (keys[a] == keys[b] && a < b); }
+
+public: // See implementation file for details
+    static SearchWorkspace& local(int slot = 0);
+
+    void begin(int vertexCount);
+    bool reached(int v) const { return stamp[v] == epoch; }
+    bool settled(int v) const { return reached(v) && heapPos[v] == SETTLED; }
+    int key(int v) const { return keys[v]; }
+    int distance(int v) const { return distances[v]; }
+    int cost(int v) const { return costs[v]; }
+    int parent(int v) const { return parents[v]; }
+
+    // Heap operations
+    bool empty() const { return heap.empty(); }
+    int minKey() const { return keys[heap.front()]; }
+    int queued() const { return static_cast<int>(heap.size()); }
+    int settledCount() const { return popped; }
+    int growthCount() const { return growths; }
+    bool improve(int v, int key, int distance, int cost, int parent);
+    int popMin();
+
+    // improve(), reporting the relaxation and any queue operation to a probe
+    template <typename Probe>
+    bool improve(int v, int key, int distance, int cost, int parent, Probe& probe) {
+        probe.relax();
+        bool labelled = reached(v);
+        if (!improve(v, key, distance, cost, parent)) return false;
+        if (labelled) {
+            probe.decreaseKey();
+        } else {
+            probe.push();
+        }
+        probe.queueSize(queued());
+        return true;
+    }
+};
+
+// Reusable per-thread state for hop-limited searches. Layer h holds the best route to each vertex that
+// uses exactly h flights, with a parent pointer into layer h - 1 instead of a copied path.
+class HopLayers {
+private:
+    std::vector<uint32_t> stamp; // Slot h * vertexCount + v is valid only while stamp == epoch
+    uint32_t epoch = 0;
+    std::vector<int> keys;
+    std::vector<int> distances;
+    std::vector<int> costs;
+    std::vector<int> parents;
+    std::vector<std::vector<int>> frontiers; // Vertices reached in each layer
+    int vertexCount = 0;
+    int layerCount = 0;
+    int growths = 0; // Times begin() had to grow the label arrays
+
+    template <typename Probe>
+    friend void runHopLimitedSearch(const FrozenGraph& g, int source, int maxHops, HopLayers& layers, Metric metric,
+                                    int target, Probe& probe);
+    friend bool extractHopRoute(const HopLayers& layers, int destination, int hops, RouteResult& result);
+
+public: // See implementation file for details
+    static HopLayers& local();
+
+    void begin(int vertexCount, int maxHops);
+    int maxHops() const { return layerCount - 1; }
+    bool reached(int hops, int v) const { return stamp[hops * vertexCount + v] == epoch; }
+    int key(int hops, int v) const { return keys[hops * vertexCount + v]; }
+    int bestHops(int v, int minHops) const;
+    int growthCount() const { return growths; }
+};
+
+// Query engines over a frozen graph. Each runs in the given workspace and leaves its labels there, and adds
+// its work to stats when given one
+void dijkstra(const FrozenGraph& g, int source, int target, SearchWorkspace& ws, Metric metric = Metric::Distance,
+              Direction direction = Direction::Forward, SearchStats* stats = nullptr);
+void dijkstraToTargets(const FrozenGraph& g, int source, const std::vector<int>& targets, SearchWorkspace& ws,
+                       Metric metric = Metric::Distance, SearchStats* stats = nullptr);
+bool extractRoute(const SearchWorkspace& ws, int destination, RouteResult& result);
+bool bidirectionalDijkstra(const FrozenGraph& g, int source, int target, SearchWorkspace& forward, SearchWorkspace& backward,
+                           RouteResult& result, Metric metric = Metric::Distance, SearchStats* stats = nullptr);
+void hopLimitedSearch(const FrozenGraph& g, int source, int maxHops, HopLayers& layers, Metric metric = Metric::Distance,
+                      int target = -1, SearchStats* stats = nullptr);
+bool extractHopRoute(const HopLayers& layers, int destination, int hops, RouteResult& result);
+
+#endif
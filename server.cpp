@@ -0,0 +1,68 @@
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include "graph.h"
+#include "loader.h"
+#include "metrics.h"
+#include "queryserver.h"
+
+// Query server: loads a route file once, then answers queries (see queryserver.h for the protocol) from stdin,
+// or from clients of a Unix domain socket with --socket PATH, until the input ends or the process is interrupted.
+// Usage: server [--socket PATH] [--threads N] [--cache MB] [--metrics] [routes file, default airports.txt]
+// Build: g++ -std=c++17 -O2 -o server server.cpp queryserver.cpp kshortest.cpp dense.cpp deltastepping.cpp graph.cpp frozengraph.cpp routing.cpp pareto.cpp contraction.cpp snapshot.cpp mappedfile.cpp loader.cpp threadpool.cpp batch.cpp allpairs.cpp connectivity.cpp spanning.cpp degrees.cpp landmarks.cpp querycache.cpp metrics.cpp metadata.cpp -pthread
+
+QueryServer* running = nullptr;
+
+// Stops the socket server on SIGINT/SIGTERM so the socket file is cleaned up
+void onSignal(int) {
+    if (running) running->stop();
+}
+
+int main(int argc, char** argv) {
+    std::string socketPath, filename = "airports.txt";
+    int threads = 0;
+    size_t cacheMegabytes = 0;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--socket" && i + 1 < argc) {
+            socketPath = argv[++i];
+        } else if (arg == "--threads" && i + 1 < argc) {
+            threads = std::atoi(argv[++i]);
+        } else if (arg == "--cache" && i + 1 < argc) {
+            cacheMegabytes = std::atoi(argv[++i]);
+        } else if (arg == "--metrics") {
+            QueryMetrics::global().enable(true);
+        } else {
+            filename = arg;
+        }
+    }
+
+    Graph g;
+    LoadReport report = loadFlightsFile(filename, g);
+    if (!report.opened) {
+        std::cerr << "Failed to open " << filename << std::endl;
+        return 1;
+    }
+    for (const auto& issue : report.errors) {
+        std::cerr << filename << ":" << issue.line << ": " << issue.message << std::endl;
+    }
+    if (cacheMegabytes > 0) g.enableQueryCache(cacheMegabytes << 20);
+
+    QueryServer server(std::move(g), threads);
+    std::cerr << "Serving " << report.rows << " flights with " << server.workers() << " workers" << std::endl;
+    if (socketPath.empty()) {
+        server.serveStream(std::cin, std::cout);
+        return 0;
+    }
+
+    running = &server;
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+    if (!server.serveSocket(socketPath)) {
+        std::cerr << "Failed to listen on " << socketPath << std::endl;
+        return 1;
+    }
+    running = nullptr;
+    return 0;
+}
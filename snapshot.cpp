@@ -0,0 +1,269 @@
+#include "snapshot.h"
+#include "contraction.h"
+#include "mappedfile.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+namespace {
+
+const char MAGIC[8] = {'A', 'P', 'G', 'R', 'A', 'P', 'H', '\0'};
+const uint32_t FORMAT_VERSION = 1;
+const uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+// Section ids; sections may appear in any order, unknown ids are ignored
+enum SectionId : uint32_t {
+    CODE_OFFSETS = 1, CODE_CHARS, STATE_OFFSETS, STATE_CHARS,
+    EDGE_OFFSETS, EDGE_TARGETS, EDGE_DISTANCES, EDGE_COSTS,
+    REVERSE_OFFSETS, REVERSE_SOURCES, REVERSE_DISTANCES, REVERSE_COSTS,
+    HIERARCHY, CONNECTIVITY,
+    SECTION_ID_END
+};
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint64_t fileSize;
+    uint64_t checksum; // FNV-1a over every byte after the header
+    uint32_t vertexCount;
+    uint32_t edgeCount;
+    uint32_t sectionCount;
+    uint32_t reserved;
+};
+
+struct SectionEntry {
+    uint32_t id;
+    uint32_t reserved;
+    uint64_t offset;
+    uint64_t size;
+};
+
+// 64-bit FNV-1a hash
+uint64_t checksum(const char* data, size_t size) {
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// Appends a string table (offsets then characters) holding stringOf(v) for every vertex v
+template <typename StringOf>
+void appendStrings(int count, StringOf&& stringOf, std::string& offsets, std::string& chars) {
+    std::vector<int> ends(1, 0);
+    for (int v = 0; v < count; ++v) {
+        chars += stringOf(v);
+        ends.push_back(static_cast<int>(chars.size()));
+    }
+    offsets.assign(reinterpret_cast<const char*>(ends.data()), ends.size() * sizeof(int));
+}
+
+// Returns the raw bytes of an int array
+std::string bytesOf(const IntArray& values) {
+    return std::string(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(int));
+}
+
+// Returns true if the array is a valid CSR offset array for the given vertex and edge counts
+bool validOffsets(const int* offsets, int vertexCount, int edgeCount) {
+    if (offsets[0] != 0 || offsets[vertexCount] != edgeCount) return false;
+    for (int v = 0; v < vertexCount; ++v) {
+        if (offsets[v] > offsets[v + 1]) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+// Writes the graph (and optionally a hierarchy built for it) to path. Returns whether the file was written
+bool GraphSnapshot::write(const std::string& path, const FrozenGraph& g, const ContractionHierarchy* hierarchy) {
+    std::vector<std::pair<uint32_t, std::string>> sections;
+    std::string offsets, chars;
+    appendStrings(g.vertexCount(), [&](int v) { return g.getAirportCode(v); }, offsets, chars);
+    sections.push_back({CODE_OFFSETS, offsets});
+    sections.push_back({CODE_CHARS, chars});
+    chars.clear();
+    appendStrings(g.vertexCount(), [&](int v) { return g.getState(v); }, offsets, chars);
+    sections.push_back({STATE_OFFSETS, offsets});
+    sections.push_back({STATE_CHARS, chars});
+    sections.push_back({EDGE_OFFSETS, bytesOf(g.edgeOffsets)});
+    sections.push_back({EDGE_TARGETS, bytesOf(g.edgeTargets)});
+    sections.push_back({EDGE_DISTANCES, bytesOf(g.edgeDistances)});
+    sections.push_back({EDGE_COSTS, bytesOf(g.edgeCosts)});
+    sections.push_back({REVERSE_OFFSETS, bytesOf(g.reverseOffsets)});
+    sections.push_back({REVERSE_SOURCES, bytesOf(g.reverseSources)});
+    sections.push_back({REVERSE_DISTANCES, bytesOf(g.reverseDistances)});
+    sections.push_back({REVERSE_COSTS, bytesOf(g.reverseCosts)});
+    if (g.connectivity && g.connectivity->vertexCount() == g.vertexCount()) {
+        std::string index;
+        g.connectivity->save(index);
+        sections.push_back({CONNECTIVITY, index});
+    }
+    if (hierarchy) {
+        std::ostringstream blob;
+        if (!hierarchy->save(blob)) return false;
+        sections.push_back({HIERARCHY, blob.str()});
+    }
+
+    // Lay out the sections after the header and table, each 8-byte aligned
+    std::vector<SectionEntry> table;
+    std::string body;
+    uint64_t position = sizeof(FileHeader) + sections.size() * sizeof(SectionEntry);
+    for (const auto& section : sections) {
+        size_t padding = (8 - (position + body.size()) % 8) % 8;
+        body.append(padding, '\0');
+        table.push_back({section.first, 0, position + body.size(), section.second.size()});
+        body += section.second;
+    }
+    std::string afterHeader(reinterpret_cast<const char*>(table.data()), table.size() * sizeof(SectionEntry));
+    afterHeader += body;
+
+    FileHeader header = {};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = FORMAT_VERSION;
+    header.byteOrder = BYTE_ORDER_MARK;
+    header.fileSize = sizeof(FileHeader) + afterHeader.size();
+    header.checksum = checksum(afterHeader.data(), afterHeader.size());
+    header.vertexCount = static_cast<uint32_t>(g.vertexCount());
+    header.edgeCount = static_cast<uint32_t>(g.edgeCount());
+    header.sectionCount = static_cast<uint32_t>(table.size());
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) return false;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(afterHeader.data(), static_cast<std::streamsize>(afterHeader.size()));
+    return static_cast<bool>(file);
+}
+
+// Records an error message and returns false
+bool GraphSnapshot::fail(const std::string& message) {
+    lastError = message;
+    mapping.reset();
+    frozen = FrozenGraph();
+    hierarchyData = nullptr;
+    hierarchySize = 0;
+    return false;
+}
+
+// Maps a snapshot file and points the graph's arrays at it. Offsets, edge endpoints and the stored connectivity
+// index are always range-checked, so a damaged file fails to open rather than being read out of bounds; with
+// verifyChecksum the whole file is also hashed
+bool GraphSnapshot::open(const std::string& path, bool verifyChecksum) {
+    fail("");
+    auto map = std::make_shared<MappedFile>();
+    if (!map->open(path)) return fail("cannot open " + path);
+    if (map->size() < sizeof(FileHeader)) return fail("file too small to be a snapshot");
+    const char* base = map->data();
+
+    // Header checks
+    FileHeader header;
+    std::memcpy(&header, base, sizeof(header));
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) return fail("not a graph snapshot");
+    if (header.byteOrder != BYTE_ORDER_MARK) return fail("snapshot was written with a different byte order");
+    if (header.version != FORMAT_VERSION) return fail("unsupported snapshot version " + std::to_string(header.version));
+    if (header.fileSize != map->size()) return fail("snapshot is truncated");
+    if (header.vertexCount > static_cast<uint32_t>(std::numeric_limits<int>::max()) ||
+        header.edgeCount > static_cast<uint32_t>(std::numeric_limits<int>::max())) return fail("snapshot counts out of range");
+    uint64_t tableEnd = sizeof(FileHeader) + static_cast<uint64_t>(header.sectionCount) * sizeof(SectionEntry);
+    if (tableEnd > map->size()) return fail("section table out of bounds");
+    if (verifyChecksum && checksum(base + sizeof(FileHeader), map->size() - sizeof(FileHeader)) != header.checksum) {
+        return fail("checksum mismatch");
+    }
+
+    // Section table
+    const char* found[SECTION_ID_END] = {};
+    uint64_t sizes[SECTION_ID_END] = {};
+    for (uint32_t i = 0; i < header.sectionCount; ++i) {
+        SectionEntry entry;
+        std::memcpy(&entry, base + sizeof(FileHeader) + i * sizeof(SectionEntry), sizeof(entry));
+        if (entry.offset < tableEnd || entry.offset > map->size() || entry.offset % 8 != 0 ||
+            entry.size > map->size() - entry.offset) {
+            return fail("section out of bounds");
+        }
+        if (entry.id > 0 && entry.id < SECTION_ID_END) {
+            found[entry.id] = base + entry.offset;
+            sizes[entry.id] = entry.size;
+        }
+    }
+    int n = static_cast<int>(header.vertexCount);
+    int m = static_cast<int>(header.edgeCount);
+    uint64_t offsetBytes = (static_cast<uint64_t>(n) + 1) * sizeof(int);
+    uint64_t edgeBytes = static_cast<uint64_t>(m) * sizeof(int);
+    uint64_t expected[SECTION_ID_END] = {0, offsetBytes, 0, offsetBytes, 0,
+                                         offsetBytes, edgeBytes, edgeBytes, edgeBytes,
+                                         offsetBytes, edgeBytes, edgeBytes, edgeBytes, 0, 0};
+    for (uint32_t id = CODE_OFFSETS; id < HIERARCHY; ++id) {
+        if (!found[id]) return fail("missing section " + std::to_string(id));
+        if (id != CODE_CHARS && id != STATE_CHARS && sizes[id] != expected[id]) return fail("section " + std::to_string(id) + " has the wrong size");
+    }
+    auto ints = [&](uint32_t id) { return reinterpret_cast<const int*>(found[id]); };
+    if (!validOffsets(ints(EDGE_OFFSETS), n, m) || !validOffsets(ints(REVERSE_OFFSETS), n, m)) return fail("corrupt edge offsets");
+    for (uint32_t id : {EDGE_TARGETS, REVERSE_SOURCES}) {
+        const unsigned* endpoints = reinterpret_cast<const unsigned*>(found[id]);
+        unsigned highest = 0;
+        for (int e = 0; e < m; ++e) highest = std::max(highest, endpoints[e]); // Branch-free, so the scan vectorizes
+        if (m > 0 && highest >= static_cast<unsigned>(n)) return fail("edge endpoint out of range");
+    }
+
+    // Vertex metadata is small, so it is interned into the compact store; edge arrays view the mapping
+    std::vector<std::string_view> tables[2];
+    for (uint32_t table : {CODE_OFFSETS, STATE_OFFSETS}) {
+        const int* ends = ints(table);
+        if (ends[0] != 0 || static_cast<uint64_t>(ends[n]) != sizes[table + 1]) return fail("corrupt string table");
+        std::vector<std::string_view>& strings = tables[table == CODE_OFFSETS ? 0 : 1];
+        strings.reserve(n);
+        for (int v = 0; v < n; ++v) {
+            if (ends[v] > ends[v + 1]) return fail("corrupt string table");
+            strings.emplace_back(found[table + 1] + ends[v], ends[v + 1] - ends[v]);
+        }
+    }
+    try {
+        frozen.airports.reserve(n);
+        for (int v = 0; v < n; ++v) {
+            if (!frozen.airports.insert(tables[0][v], tables[1][v]).second) return fail("duplicate airport code");
+        }
+    } catch (const std::string& message) {
+        return fail(message);
+    }
+    frozen.buildStateIndex();
+    frozen.edgeOffsets = IntArray(ints(EDGE_OFFSETS), n + 1);
+    frozen.edgeTargets = IntArray(ints(EDGE_TARGETS), m);
+    frozen.edgeDistances = IntArray(ints(EDGE_DISTANCES), m);
+    frozen.edgeCosts = IntArray(ints(EDGE_COSTS), m);
+    frozen.reverseOffsets = IntArray(ints(REVERSE_OFFSETS), n + 1);
+    frozen.reverseSources = IntArray(ints(REVERSE_SOURCES), m);
+    frozen.reverseDistances = IntArray(ints(REVERSE_DISTANCES), m);
+    frozen.reverseCosts = IntArray(ints(REVERSE_COSTS), m);
+    frozen.backing = map;
+
+    // The reachability index is stored by write(); files without it get it rebuilt from the edges
+    auto connectivity = std::make_shared<ConnectivityIndex>();
+    if (!found[CONNECTIVITY]) {
+        connectivity->build(n, frozen.edgeOffsets.data(), frozen.edgeTargets.data());
+    } else if (!connectivity->load(found[CONNECTIVITY], sizes[CONNECTIVITY], n)) {
+        return fail("corrupt connectivity index");
+    }
+    frozen.connectivity = connectivity;
+    hierarchyData = found[HIERARCHY];
+    hierarchySize = sizes[HIERARCHY];
+    mapping = map;
+
+    // A stored hierarchy answers the graph's point-to-point queries from the start
+    if (hierarchyData) {
+        auto hierarchy = std::make_shared<ContractionHierarchy>();
+        if (!loadHierarchy(*hierarchy)) return fail("corrupt contraction hierarchy");
+        frozen.attachHierarchy(hierarchy);
+    }
+    return true;
+}
+
+// Loads the optional hierarchy section. Returns false if there is none or it does not match the graph
+bool GraphSnapshot::loadHierarchy(ContractionHierarchy& hierarchy) const {
+    if (!hierarchyData) return false;
+    std::istringstream in(std::string(hierarchyData, hierarchySize));
+    return hierarchy.load(in, frozen);
+}
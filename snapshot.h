@@ -0,0 +1,40 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "frozengraph.h"
+#include "mappedfile.h"
+
+class ContractionHierarchy;
+
+// Versioned, checksummed binary snapshot of a frozen graph.
+// The file is a fixed header, a section table and 8-byte aligned sections: the airport code and state
+// string tables, the outbound and inbound CSR arrays, the connectivity index, and optionally a serialized
+// contraction hierarchy.
+// open() maps the file read-only and shared, and the graph's edge arrays view the mapped pages directly,
+// so several processes serving the same file share one page-cache copy. A stored hierarchy is loaded and
+// attached to the graph, so its route queries search it.
+class GraphSnapshot {
+private:
+    std::shared_ptr<MappedFile> mapping;
+    FrozenGraph frozen;
+    const char* hierarchyData = nullptr;
+    size_t hierarchySize = 0;
+    std::string lastError;
+
+    bool fail(const std::string& message);
+
+public: // See implementation file for details
+    static bool write(const std::string& path, const FrozenGraph& g, const ContractionHierarchy* hierarchy = nullptr);
+
+    bool open(const std::string& path, bool verifyChecksum = true);
+    const FrozenGraph& graph() const { return frozen; }
+    bool hasHierarchy() const { return hierarchyData != nullptr; }
+    bool loadHierarchy(ContractionHierarchy& hierarchy) const;
+    const std::string& error() const { return lastError; }
+};
+
+#endif
@@ -0,0 +1,211 @@
+#include "spanning.h"
+#include "dense.h"
+#include "frozengraph.h"
+#include "threadpool.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <numeric>
+
+// Union-find with union by rank and path halving, so both operations run in near-constant amortized time
+class DisjointSets {
+private:
+    std::vector<int> parent;
+    std::vector<unsigned char> rank;
+
+public:
+    explicit DisjointSets(int n) : parent(n), rank(n, 0) {
+        std::iota(parent.begin(), parent.end(), 0);
+    }
+
+    // Returns the representative of x's set, pointing every other node on the way at its grandparent
+    int find(int x) {
+        while (parent[x] != x) {
+            parent[x] = parent[parent[x]];
+            x = parent[x];
+        }
+        return x;
+    }
+
+    // Merges the sets of x and y. Returns false if they were already the same set
+    bool unite(int x, int y) {
+        x = find(x);
+        y = find(y);
+        if (x == y) return false;
+        if (rank[x] < rank[y]) std::swap(x, y);
+        parent[y] = x;
+        if (rank[x] == rank[y]) rank[x]++;
+        return true;
+    }
+};
+
+// Returns the weight of flight e under the given metric
+static int edgeWeight(const FrozenGraph& g, int e, Metric metric) {
+    return (metric == Metric::Distance) ? g.edgeDistance(e) : g.edgeCost(e);
+}
+
+// Splits the chosen edges into one tree per component, numbering trees by their lowest airport index
+static void groupTrees(int n, SpanningForest& forest) {
+    DisjointSets sets(n);
+    for (const auto& edge : forest.edges) sets.unite(edge.u, edge.v);
+
+    std::vector<int> treeOf(n, -1); // Tree index of each set representative
+    for (int v = 0; v < n; ++v) {
+        int root = sets.find(v);
+        if (treeOf[root] == -1) {
+            treeOf[root] = static_cast<int>(forest.trees.size());
+            forest.trees.emplace_back();
+        }
+        forest.trees[treeOf[root]].vertices.push_back(v);
+    }
+    for (const auto& edge : forest.edges) {
+        SpanningTree& tree = forest.trees[treeOf[sets.find(edge.u)]];
+        tree.edges.push_back(edge);
+        tree.weight += edge.weight;
+        forest.weight += edge.weight;
+    }
+}
+
+// Prim's algorithm on the 4-ary decrease-key heap, O(E log V). Each component is grown from its lowest
+// unvisited airport; flights are followed in both directions through the outbound and inbound CSR arrays.
+// Small dense graphs run the O(V^2) dense engine on a symmetric matrix instead, which picks the same edges
+SpanningForest primForest(const FrozenGraph& g, Metric metric) {
+    SpanningForest forest;
+    int n = g.vertexCount();
+    if (preferDense(n, 2LL * g.edgeCount())) { // Every flight is relaxed from both ends
+        thread_local DenseMatrix matrix; // Keeps its buffer between calls of the same size
+        matrix.buildUndirected(g, metric);
+        DenseWorkspace& dense = DenseWorkspace::local();
+        thread_local std::vector<int> order;
+        densePrim(matrix, dense, order);
+        for (int u : order) {
+            if (dense.parent(u) != -1) forest.edges.push_back({dense.parent(u), u, dense.key(u)});
+        }
+        groupTrees(n, forest);
+        return forest;
+    }
+
+    SearchWorkspace& ws = SearchWorkspace::local();
+    ws.begin(n);
+
+    for (int root = 0; root < n; ++root) {
+        if (ws.reached(root)) continue;
+        ws.improve(root, 0, 0, 0, -1);
+        while (!ws.empty()) {
+            int u = ws.popMin();
+            if (ws.parent(u) != -1) forest.edges.push_back({ws.parent(u), u, ws.key(u)});
+
+            for (int e = g.edgeBegin(u); e < g.edgeEnd(u); ++e) {
+                ws.improve(g.edgeTarget(e), edgeWeight(g, e, metric), 0, 0, u);
+            }
+            for (int e = g.reverseBegin(u); e < g.reverseEnd(u); ++e) {
+                int weight = (metric == Metric::Distance) ? g.reverseDistance(e) : g.reverseCost(e);
+                ws.improve(g.reverseSource(e), weight, 0, 0, u);
+            }
+        }
+    }
+    groupTrees(n, forest);
+    return forest;
+}
+
+// Kruskal's algorithm: flights sorted once by weight (ties keep flight order), then merged through the
+// union-find, O(E log E)
+SpanningForest kruskalForest(const FrozenGraph& g, Metric metric) {
+    SpanningForest forest;
+    int n = g.vertexCount();
+
+    std::vector<SpanningEdge> candidates;
+    candidates.reserve(g.edgeCount());
+    for (int u = 0; u < n; ++u) {
+        for (int e = g.edgeBegin(u); e < g.edgeEnd(u); ++e) {
+            int v = g.edgeTarget(e);
+            if (u != v) candidates.push_back({std::min(u, v), std::max(u, v), edgeWeight(g, e, metric)});
+        }
+    }
+    std::stable_sort(candidates.begin(), candidates.end(),
+                     [](const SpanningEdge& a, const SpanningEdge& b) { return a.weight < b.weight; });
+
+    DisjointSets sets(n);
+    for (const auto& edge : candidates) {
+        if (sets.unite(edge.u, edge.v)) {
+            forest.edges.push_back(edge);
+            if (static_cast<int>(forest.edges.size()) == n - 1) break; // Already one spanning tree
+        }
+    }
+    groupTrees(n, forest);
+    return forest;
+}
+
+// Boruvka's algorithm on the thread pool. Each round every component picks its lightest incident flight in
+// parallel (an atomic minimum over (weight, flight index), so ties break the same way everywhere and no
+// cycle can form), the picks are merged, and flights now inside a component are dropped. The number of
+// components at least halves per round, so there are O(log V) rounds of O(E / threads) work each.
+SpanningForest boruvkaForest(const FrozenGraph& g, ThreadPool& pool, Metric metric) {
+    const uint64_t NONE = UINT64_MAX;
+    SpanningForest forest;
+    int n = g.vertexCount();
+
+    std::vector<int> source(g.edgeCount());
+    std::vector<int> active; // Flights that may still join two components
+    active.reserve(g.edgeCount());
+    for (int u = 0; u < n; ++u) {
+        for (int e = g.edgeBegin(u); e < g.edgeEnd(u); ++e) {
+            source[e] = u;
+            if (g.edgeTarget(e) != u) active.push_back(e);
+        }
+    }
+
+    std::vector<int> label(n); // Component representative of each airport
+    std::iota(label.begin(), label.end(), 0);
+    std::unique_ptr<std::atomic<uint64_t>[]> lightest(new std::atomic<uint64_t>[n]);
+    DisjointSets sets(n);
+
+    size_t chunks = static_cast<size_t>(pool.size()) * 8;
+    std::vector<std::vector<int>> survivors(chunks);
+    while (!active.empty()) {
+        for (int c = 0; c < n; ++c) lightest[c].store(NONE, std::memory_order_relaxed);
+
+        // Lightest flight leaving each component; flights inside one are dropped
+        size_t chunkSize = (active.size() + chunks - 1) / chunks;
+        pool.parallelFor(chunks, [&](size_t chunk) {
+            std::vector<int>& kept = survivors[chunk];
+            kept.clear();
+            size_t begin = chunk * chunkSize;
+            size_t end = std::min(active.size(), begin + chunkSize);
+            for (size_t i = begin; i < end; ++i) {
+                int e = active[i];
+                int cu = label[source[e]], cv = label[g.edgeTarget(e)];
+                if (cu == cv) continue;
+                kept.push_back(e);
+                uint64_t key = (static_cast<uint64_t>(static_cast<uint32_t>(edgeWeight(g, e, metric)) ^ 0x80000000u) << 32) |
+                               static_cast<uint32_t>(e);
+                for (int c : {cu, cv}) {
+                    uint64_t current = lightest[c].load(std::memory_order_relaxed);
+                    while (key < current && !lightest[c].compare_exchange_weak(current, key, std::memory_order_relaxed)) {
+                    }
+                }
+            }
+        });
+
+        // Merge every component with its pick
+        bool merged = false;
+        for (int c = 0; c < n; ++c) {
+            uint64_t key = lightest[c].load(std::memory_order_relaxed);
+            if (label[c] != c || key == NONE) continue;
+            int e = static_cast<int>(key & 0xFFFFFFFFu);
+            int u = source[e], v = g.edgeTarget(e);
+            if (sets.unite(u, v)) {
+                forest.edges.push_back({std::min(u, v), std::max(u, v), edgeWeight(g, e, metric)});
+                merged = true;
+            }
+        }
+        if (!merged) break;
+
+        for (int v = 0; v < n; ++v) label[v] = sets.find(v);
+        active.clear();
+        for (const auto& kept : survivors) active.insert(active.end(), kept.begin(), kept.end());
+    }
+    groupTrees(n, forest);
+    return forest;
+}
@@ -0,0 +1,37 @@
+#ifndef SPANNING_H
+#define SPANNING_H
+
+#include <vector>
+#include "routing.h"
+
+class FrozenGraph;
+class ThreadPool;
+
+// Tree edge between two airport indices
+struct SpanningEdge {
+    int u;
+    int v;
+    int weight;
+};
+
+// Minimum spanning tree of one connected component (a lone airport is a tree with no edges)
+struct SpanningTree {
+    std::vector<int> vertices; // Airport indices in ascending order
+    std::vector<SpanningEdge> edges; // In the order the algorithm chose them
+    long long weight = 0;
+};
+
+// Minimum spanning forest: one tree per component, ordered by their lowest airport index
+struct SpanningForest {
+    std::vector<SpanningTree> trees;
+    std::vector<SpanningEdge> edges; // Every tree edge, in the order the algorithm chose them
+    long long weight = 0;
+};
+
+// Minimum spanning forest engines. Every flight counts as an undirected edge weighted by the given metric,
+// so the forest spans the weakly connected components of the graph.
+SpanningForest primForest(const FrozenGraph& g, Metric metric = Metric::Cost);
+SpanningForest kruskalForest(const FrozenGraph& g, Metric metric = Metric::Cost);
+SpanningForest boruvkaForest(const FrozenGraph& g, ThreadPool& pool, Metric metric = Metric::Cost);
+
+#endif
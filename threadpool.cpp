@@ -0,0 +1,98 @@
+#include "threadpool.h"
+#include <algorithm>
+
+// Starts threadCount - 1 pool threads (the caller is the last worker). 0 means one worker per hardware thread
+ThreadPool::ThreadPool(int threadCount) {
+    if (threadCount <= 0) threadCount = std::max(1u, std::thread::hardware_concurrency());
+    for (int i = 0; i < threadCount; ++i) {
+        queues.push_back(std::unique_ptr<TaskQueue>(new TaskQueue()));
+    }
+    for (int i = 0; i + 1 < threadCount; ++i) {
+        threads.emplace_back(&ThreadPool::workerLoop, this, static_cast<size_t>(i));
+    }
+}
+
+// Stops and joins the pool threads
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> guard(stateLock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& thread : threads) thread.join();
+}
+
+// Runs task(i) for every i in [0, count) across the pool and returns when all of them have finished
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& task) {
+    if (count == 0) return;
+    std::lock_guard<std::mutex> submit(submitLock);
+
+    // Publish the job before any task becomes visible to a thread still draining from the last call
+    job = &task;
+    remaining = count;
+
+    // Deal contiguous blocks so neighbouring tasks start on the same thread
+    size_t workers = queues.size();
+    for (size_t w = 0; w < workers; ++w) {
+        size_t begin = count * w / workers, end = count * (w + 1) / workers;
+        std::lock_guard<std::mutex> guard(queues[w]->lock);
+        for (size_t i = begin; i < end; ++i) queues[w]->tasks.push_back(i);
+    }
+    {
+        std::lock_guard<std::mutex> guard(stateLock);
+        generation++;
+    }
+    wake.notify_all();
+
+    // The caller works too, then waits for stragglers
+    size_t self = workers - 1;
+    while (runOne(self)) {}
+    std::unique_lock<std::mutex> guard(stateLock);
+    finished.wait(guard, [&] { return remaining == 0; });
+    job = nullptr;
+}
+
+// Runs one task from this worker's deque, or stolen from another. Returns false if every deque was empty
+bool ThreadPool::runOne(size_t self) {
+    size_t index = 0;
+    bool found = false;
+    {
+        std::lock_guard<std::mutex> guard(queues[self]->lock);
+        if (!queues[self]->tasks.empty()) {
+            index = queues[self]->tasks.back();
+            queues[self]->tasks.pop_back();
+            found = true;
+        }
+    }
+    for (size_t k = 1; !found && k < queues.size(); ++k) {
+        TaskQueue& victim = *queues[(self + k) % queues.size()];
+        std::lock_guard<std::mutex> guard(victim.lock);
+        if (!victim.tasks.empty()) {
+            index = victim.tasks.front();
+            victim.tasks.pop_front();
+            found = true;
+        }
+    }
+    if (!found) return false;
+
+    (*job.load())(index);
+    if (--remaining == 0) {
+        std::lock_guard<std::mutex> guard(stateLock);
+        finished.notify_all();
+    }
+    return true;
+}
+
+// Pool thread body: sleep until a new parallelFor starts, then drain and steal until nothing is left
+void ThreadPool::workerLoop(size_t self) {
+    uint64_t seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> guard(stateLock);
+            wake.wait(guard, [&] { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+        }
+        while (runOne(self)) {}
+    }
+}
@@ -0,0 +1,49 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed-size work-stealing thread pool. parallelFor deals task indices out to one deque per thread; each
+// thread works from the back of its own deque and, when that runs dry, steals from the front of another's.
+// The calling thread is one of the workers, so a pool of N workers starts N - 1 threads.
+class ThreadPool {
+private:
+    struct TaskQueue {
+        std::mutex lock;
+        std::deque<size_t> tasks;
+    };
+
+    std::vector<std::thread> threads;
+    std::vector<std::unique_ptr<TaskQueue>> queues; // One per pool thread plus one for the caller
+    std::atomic<const std::function<void(size_t)>*> job{nullptr};
+    std::atomic<size_t> remaining{0};
+    std::mutex stateLock;
+    std::condition_variable wake;
+    std::condition_variable finished;
+    uint64_t generation = 0;
+    bool stopping = false;
+    std::mutex submitLock; // One parallelFor at a time
+
+    bool runOne(size_t self);
+    void workerLoop(size_t self);
+
+public: // See implementation file for details
+    explicit ThreadPool(int threadCount = 0);
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    ~ThreadPool();
+
+    int size() const { return static_cast<int>(queues.size()); }
+    void parallelFor(size_t count, const std::function<void(size_t)>& task);
+};
+
+#endif